@@ -0,0 +1,814 @@
+/*
+ * @brief Benchmarks for the SimpleLogger hot paths and every logger
+ *
+ * Usage: SimpleLoggerBench [--format text|json|csv] [--output file] [--quick]
+ * Text is printed as the benchmarks run, json and csv are written once everything finished (to stdout unless an
+ * output file is given) so results can be compared between releases. Exits with 1 if a path that must not allocate
+ * did.
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "binarylog.hpp"
+#include "compressedlog.hpp"
+#include "repeatfilter.hpp"
+#include "simplelogger.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "flightrecorder.hpp"
+#endif // _WIN32
+
+/* Every heap allocation in the process (backend thread included), so steady state logging can be checked for them */
+std::atomic<uint64_t> s_allocations = 0;
+
+/* Kept out of line like the deletes, inlined GCC pairs malloc() with operator delete or operator new with free() and
+ * warns about the mismatch (-Wmismatched-new-delete) */
+[[gnu::noinline]] void *operator new(const std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size); memory != nullptr)
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void *operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    const auto align = static_cast<std::size_t>(alignment);
+    if (void *memory = std::aligned_alloc(align, (size + align - 1) / align * align); memory != nullptr)
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *memory) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+[[gnu::noinline]] void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+namespace
+{
+
+/* --quick divides every iteration count by this */
+constexpr uint64_t QUICK_DIVISOR = 10;
+
+uint64_t s_iterations = 10'000'000;
+/* Async runs use thread buffers at least this big so they measure the calling thread only */
+uint64_t s_writeIterations = 50'000;
+/* Writes to real loggers, each of them is also timed call by call for the latency percentiles */
+uint64_t s_sinkIterations = 200'000;
+
+constexpr double NOT_MEASURED = std::numeric_limits<double>::quiet_NaN();
+
+/** One row of the results, values that weren't measured for it are NaN */
+struct Result
+{
+    std::string name;
+    uint32_t threads = 1;
+    double nsPerOp = NOT_MEASURED;
+    /* Calls per second over all threads, end to end (async runs include draining the queue) */
+    double opsPerSecond = NOT_MEASURED;
+    double p50 = NOT_MEASURED;
+    double p99 = NOT_MEASURED;
+    double p999 = NOT_MEASURED;
+    double allocsPerOp = NOT_MEASURED;
+    /* The row fails the run if allocsPerOp isn't 0 */
+    bool mustNotAllocate = false;
+};
+
+enum class OutputFormat
+{
+    TEXT,
+    JSON,
+    CSV
+};
+
+std::vector<Result> s_results;
+OutputFormat s_format = OutputFormat::TEXT;
+
+/* Keeps the compiler from throwing away the benchmarked work */
+template<typename T>
+void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Log-linear latency histogram, 32 buckets per power of two so percentiles are within ~3% of the exact value
+ * Fixed size, recording is an index computation and an increment.
+ */
+class LatencyHistogram
+{
+public:
+    void record(const uint64_t ns) { m_counts[index(ns)]++; }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (std::size_t i = 0; i < m_counts.size(); i++)
+            m_counts[i] += other.m_counts[i];
+    }
+
+    /** Value at the given percentile (0-1) in ns, the middle of its bucket */
+    [[nodiscard]] double percentile(const double fraction) const
+    {
+        uint64_t total = 0;
+        for (const uint64_t count: m_counts)
+            total += count;
+
+        if (total == 0)
+            return NOT_MEASURED;
+
+        const auto target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < m_counts.size(); i++)
+        {
+            seen += m_counts[i];
+            if (seen >= target and m_counts[i] != 0)
+                return midpoint(i);
+        }
+
+        return midpoint(m_counts.size() - 1);
+    }
+
+private:
+    static constexpr uint32_t SUB_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BITS;
+
+    std::array<uint64_t, 64 * SUB_BUCKETS> m_counts{};
+
+    static std::size_t index(const uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS)
+            return ns;
+
+        const auto shift = static_cast<uint32_t>(std::bit_width(ns)) - 1 - SUB_BITS;
+        return ((shift + 1) << SUB_BITS) + ((ns >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static double midpoint(const std::size_t index)
+    {
+        if (index < SUB_BUCKETS)
+            return static_cast<double>(index);
+
+        const uint64_t shift = (index >> SUB_BITS) - 1;
+        const uint64_t lower = (SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift;
+        return static_cast<double>(lower) + static_cast<double>((uint64_t{1} << shift) - 1) / 2;
+    }
+};
+
+template<typename Function>
+double nsPerOp(const uint64_t iterations, Function &&function)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < iterations; i++)
+        function(i);
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           static_cast<double>(iterations);
+}
+
+/** Times every call on its own, the two clock reads per call are included in the result */
+template<typename Function>
+void recordLatencies(LatencyHistogram &histogram, const uint64_t iterations, Function &&function)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function(i);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+}
+
+void setLatencies(Result &result, const LatencyHistogram &histogram)
+{
+    result.p50 = histogram.percentile(0.50);
+    result.p99 = histogram.percentile(0.99);
+    result.p999 = histogram.percentile(0.999);
+}
+
+/** Starts threads threads at once and waits for them, the function gets the thread's index */
+template<typename Function>
+void runThreads(const uint32_t threads, Function &&function)
+{
+    std::vector<std::thread> workers;
+    std::atomic<bool> go = false;
+
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back(
+                [&, t]
+                {
+                    while (!go.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+
+                    function(t);
+                });
+    }
+
+    go.store(true, std::memory_order_release);
+    for (auto &worker: workers)
+        worker.join();
+}
+
+/** Runs the function on threads threads at once and reports the average ns/op per thread */
+template<typename Function>
+double nsPerOpThreaded(const uint32_t threads, const uint64_t iterations, Function &&function)
+{
+    std::vector<double> results(threads);
+    runThreads(threads, [&](const uint32_t t) { results[t] = nsPerOp(iterations, function); });
+
+    double total = 0;
+    for (const double result: results)
+        total += result;
+
+    return total / threads;
+}
+
+/**
+ * Throughput of threads threads calling function iterations times each, finish runs once they're done and counts
+ * towards the time (a flush, so asynchronous records are actually written). The same threads warm up first (their
+ * async buffers are created on the first record) and time every call for the latencies afterward.
+ */
+template<typename Function, typename Finish>
+Result throughput(const std::string &name, const uint32_t threads, const uint64_t iterations, Function &&function,
+                  Finish &&finish)
+{
+    std::vector<double> ns(threads);
+    std::vector<LatencyHistogram> histograms(threads);
+    std::barrier phase(static_cast<std::ptrdiff_t>(threads) + 1);
+    std::vector<std::thread> workers;
+
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back(
+                [&, t]
+                {
+                    nsPerOp(iterations, function);
+                    phase.arrive_and_wait(); // Warmed up
+                    phase.arrive_and_wait(); // Go
+                    ns[t] = nsPerOp(iterations, function);
+                    phase.arrive_and_wait(); // Done, finish() runs
+                    phase.arrive_and_wait();
+                    recordLatencies(histograms[t], iterations, function);
+                });
+    }
+
+    phase.arrive_and_wait();
+    finish();
+
+    const auto start = std::chrono::steady_clock::now();
+    phase.arrive_and_wait();
+    phase.arrive_and_wait();
+    finish();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    phase.arrive_and_wait();
+
+    for (auto &worker: workers)
+        worker.join();
+    finish();
+
+    Result result{.name = name, .threads = threads};
+
+    double total = 0;
+    for (const double value: ns)
+        total += value;
+    result.nsPerOp = total / threads;
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    result.opsPerSecond = static_cast<double>(threads * iterations) / seconds;
+
+    for (uint32_t t = 1; t < threads; t++)
+        histograms[0].merge(histograms[t]);
+    setLatencies(result, histograms[0]);
+
+    return result;
+}
+
+/** Discards everything, so benchmarks measure the logger instead of the terminal */
+class NullLogger final : public slog::LoggerLoc
+{
+public:
+    void log(const std::string &message, slog::LogLevel) override { doNotOptimize(message.size()); }
+    void exception(const slog::LogException &exception) override { doNotOptimize(exception.what()); }
+    void logRecord(const slog::LogRecord &record) override { doNotOptimize(record.message.size()); }
+};
+
+/**
+ * Heap allocations per call once the function (and finish, like a flush) have warmed up
+ * Two warm-up rounds, so every reused record (async buffer cells included) has grown its buffers before counting.
+ */
+template<typename Function, typename Finish>
+double allocationsPerOp(const uint64_t iterations, Function &&function, Finish &&finish)
+{
+    for (int round = 0; round < 2; round++)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+            function(i);
+        finish();
+    }
+
+    const uint64_t before = s_allocations.load();
+
+    for (uint64_t i = 0; i < iterations; i++)
+        function(i);
+    finish();
+
+    return static_cast<double>(s_allocations.load() - before) / static_cast<double>(iterations);
+}
+
+/** Keeps the result and prints it right away for text output */
+void report(const Result &result)
+{
+    s_results.push_back(result);
+
+    if (s_format != OutputFormat::TEXT)
+        return;
+
+    std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(2);
+
+    if (!std::isnan(result.nsPerOp))
+        std::cout << std::setw(10) << result.nsPerOp << " ns/op";
+    if (!std::isnan(result.opsPerSecond))
+        std::cout << std::setw(10) << result.opsPerSecond / 1e6 << " Mops/s";
+    if (!std::isnan(result.p50))
+    {
+        std::cout << std::setprecision(0) << "  p50 " << result.p50 << " p99 " << result.p99 << " p999 "
+                  << result.p999 << " ns" << std::setprecision(2);
+    }
+    if (!std::isnan(result.allocsPerOp))
+    {
+        std::cout << std::setw(10) << result.allocsPerOp << " allocs/op"
+                  << (result.mustNotAllocate and result.allocsPerOp > 0 ? "  FAILED" : "");
+    }
+
+    std::cout << std::endl;
+}
+
+void report(const std::string &name, const double ns) { report(Result{.name = name, .nsPerOp = ns}); }
+
+void reportAllocations(const std::string &name, const double allocations)
+{
+    report(Result{.name = name, .allocsPerOp = allocations, .mustNotAllocate = true});
+}
+
+void appendNumber(std::string &out, const double value)
+{
+    if (std::isnan(value))
+        return;
+
+    std::ostringstream number;
+    number << std::fixed << std::setprecision(2) << value;
+    out += number.str();
+}
+
+std::string formatJson()
+{
+    std::string out = "{\n  \"version\": ";
+    slog::appendJsonString(out, slog::SimpleLoggerVersion);
+    out += ",\n  \"hardware_threads\": " + std::to_string(std::thread::hardware_concurrency());
+    out += ",\n  \"results\": [";
+
+    for (std::size_t i = 0; i < s_results.size(); i++)
+    {
+        const Result &result = s_results[i];
+
+        out += i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ";
+        slog::appendJsonString(out, result.name);
+        out += ", \"threads\": " + std::to_string(result.threads);
+
+        const std::array<std::pair<const char *, double>, 6> values{{{"ns_per_op", result.nsPerOp},
+                                                                     {"ops_per_sec", result.opsPerSecond},
+                                                                     {"p50_ns", result.p50},
+                                                                     {"p99_ns", result.p99},
+                                                                     {"p999_ns", result.p999},
+                                                                     {"allocs_per_op", result.allocsPerOp}}};
+
+        for (const auto &[key, value]: values)
+        {
+            out += ", \"";
+            out += key;
+            out += "\": ";
+
+            if (std::isnan(value))
+                out += "null";
+            else
+                appendNumber(out, value);
+        }
+
+        out += "}";
+    }
+
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+std::string formatCsv()
+{
+    std::string out = "name,threads,ns_per_op,ops_per_sec,p50_ns,p99_ns,p999_ns,allocs_per_op\n";
+
+    for (const Result &result: s_results)
+    {
+        // Names contain commas ("async, 2 threads"), quote them
+        out += '"';
+        for (const char c: result.name)
+        {
+            if (c == '"')
+                out += '"';
+            out += c;
+        }
+        out += "\"," + std::to_string(result.threads);
+
+        for (const double value: {result.nsPerOp, result.opsPerSecond, result.p50, result.p99, result.p999,
+                                  result.allocsPerOp})
+        {
+            out += ',';
+            appendNumber(out, value);
+        }
+
+        out += '\n';
+    }
+
+    return out;
+}
+
+/** tmpfs if there is one, so file loggers are measured without the disk */
+std::filesystem::path benchDirectory()
+{
+    std::error_code error;
+    if (std::filesystem::is_directory("/dev/shm", error))
+        return "/dev/shm";
+
+    return std::filesystem::temp_directory_path();
+}
+
+std::string benchFile(const std::string &name)
+{
+#ifndef _WIN32
+    const std::string id = std::to_string(getpid());
+#else
+    const std::string id = "0";
+#endif // _WIN32
+
+    return (benchDirectory() / ("slog-bench-" + id + "-" + name)).string();
+}
+
+/** Removes every file a logger made from the bench file name (rotations and segments included) */
+void removeBenchFiles(const std::string &path)
+{
+    const std::filesystem::path file(path);
+    std::error_code error;
+
+    for (const auto &entry: std::filesystem::directory_iterator(file.parent_path(), error))
+    {
+        if (entry.path().filename().string().starts_with(file.filename().string()))
+            std::filesystem::remove(entry.path(), error);
+    }
+}
+
+/** Points stdout and stderr at /dev/null while it exists, for the console loggers (they write to the descriptors) */
+class SilenceConsole
+{
+public:
+    SilenceConsole()
+    {
+        std::cout << std::flush;
+        std::cerr << std::flush;
+
+#ifndef _WIN32
+        const int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        m_out = dup(STDOUT_FILENO);
+        m_err = dup(STDERR_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(null);
+#endif // _WIN32
+    }
+
+    ~SilenceConsole()
+    {
+#ifndef _WIN32
+        dup2(m_out, STDOUT_FILENO);
+        dup2(m_err, STDERR_FILENO);
+        close(m_out);
+        close(m_err);
+#endif // _WIN32
+    }
+
+    SilenceConsole(const SilenceConsole &) = delete;
+    SilenceConsole &operator=(const SilenceConsole &) = delete;
+
+private:
+    int m_out = -1;
+    int m_err = -1;
+};
+
+/**
+ * Synchronous SL_LOGD_INFO through the global logger with only this logger attached
+ * ns/op, latency percentiles and allocations per call are each measured in their own pass.
+ */
+void benchLogger(const std::string &name, const std::shared_ptr<slog::LoggerLoc> &loggerLoc, const bool console,
+                 const bool mustNotAllocate = false)
+{
+    auto *logger = slog::SimpleLogger::GlobalLogger();
+    logger->clearLoggers();
+    logger->addLogger(loggerLoc);
+
+    const auto call = [](const uint64_t i) { SL_LOGD_INFO("Request {} took {} us from {}", i, i * 3, "host"); };
+    const auto flush = [logger] { logger->flush(); };
+
+    Result result{.name = name, .mustNotAllocate = mustNotAllocate};
+    LatencyHistogram histogram;
+    {
+        std::unique_ptr<SilenceConsole> silence = console ? std::make_unique<SilenceConsole>() : nullptr;
+
+        nsPerOp(s_sinkIterations / 10, call);
+        result.nsPerOp = nsPerOp(s_sinkIterations, call);
+        result.opsPerSecond = 1e9 / result.nsPerOp;
+        recordLatencies(histogram, s_sinkIterations, call);
+        result.allocsPerOp = allocationsPerOp(s_sinkIterations, call, flush);
+    }
+    setLatencies(result, histogram);
+
+    logger->clearLoggers();
+    report(result);
+}
+
+void parseArguments(const int argc, char **argv, std::string &output)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--format" and i + 1 < argc)
+        {
+            const std::string format = argv[++i];
+            if (format == "json")
+                s_format = OutputFormat::JSON;
+            else if (format == "csv")
+                s_format = OutputFormat::CSV;
+            else if (format == "text")
+                s_format = OutputFormat::TEXT;
+            else
+                throw std::invalid_argument("Unknown format " + format + ", expected text, json or csv");
+        }
+        else if (argument == "--output" and i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (argument == "--quick")
+        {
+            s_iterations /= QUICK_DIVISOR;
+            s_writeIterations /= QUICK_DIVISOR;
+            s_sinkIterations /= QUICK_DIVISOR;
+        }
+        else
+        {
+            throw std::invalid_argument("Usage: " + std::string(argv[0]) +
+                                        " [--format text|json|csv] [--output file] [--quick]");
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string output;
+    try
+    {
+        parseArguments(argc, argv, output);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 2;
+    }
+
+    auto *logger = slog::SimpleLogger::GlobalLogger();
+    logger->setMinLogLevel(slog::LogLevel::INFO);
+
+    const uint32_t maxThreads = std::max(2u, std::thread::hardware_concurrency());
+
+    // Global dispatch path, everything here is filtered out before a record exists
+    report("GlobalLogger() access",
+           nsPerOp(s_iterations, [](const uint64_t) { doNotOptimize(slog::SimpleLogger::GlobalLogger()); }));
+
+    report("Filtered SL_LOG_DEBUG (1 thread)",
+           nsPerOp(s_iterations, [](const uint64_t) { SL_LOG_DEBUG("This message is filtered out"); }));
+
+    report("Filtered SL_LOG_DEBUG with concatenation",
+           nsPerOp(s_iterations,
+                   [](const uint64_t i) { SL_LOG_DEBUG("Argument: " + std::to_string(i) + " is filtered out"); }));
+
+    report("formatTime()",
+           nsPerOp(s_iterations, [](const uint64_t)
+                   { doNotOptimize(slog::formatTime(std::chrono::system_clock::now()).length); }));
+
+    for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+    {
+        Result result{.name = "Filtered SL_LOG_DEBUG (" + std::to_string(threads) + " threads)", .threads = threads};
+        result.nsPerOp = nsPerOpThreaded(threads, s_iterations / threads,
+                                         [](const uint64_t) { SL_LOG_DEBUG("This message is filtered out"); });
+        report(result);
+    }
+
+    // Logging must not allocate once the reused records have grown, concatenating at the call site of course does
+    logger->clearLoggers();
+    logger->addLogger(std::make_shared<NullLogger>());
+
+    const auto noFinish = [] {};
+
+    reportAllocations("SL_LOG_INFO", allocationsPerOp(s_writeIterations,
+                                                      [](const uint64_t) { SL_LOG_INFO("Request done"); }, noFinish));
+    reportAllocations("SL_LOGD_INFO",
+                      allocationsPerOp(s_writeIterations, [](const uint64_t i)
+                                       { SL_LOGD_INFO("Request {} took {} us from {}", i, i * 3, "host"); },
+                                       noFinish));
+    reportAllocations("SL_LOG_INFO_KV",
+                      allocationsPerOp(s_writeIterations, [](const uint64_t i)
+                                       { SL_LOG_INFO_KV("Request done", "id", i, "latency_us", i * 3); }, noFinish));
+
+    // Every logger on its own, synchronously
+    const std::string plainFile = benchFile("file.log");
+    const std::string bufferedFile = benchFile("buffered.log");
+    const std::string binaryFile = benchFile("binary.slog");
+    const std::string jsonFile = benchFile("json.log");
+    const std::string logfmtFile = benchFile("logfmt.log");
+    const std::string filteredFile = benchFile("filtered.log");
+    const std::string compressedFile = benchFile("compressed.log.gz");
+
+    benchLogger("SimpleConsoleLogger (/dev/null)", std::make_shared<slog::SimpleConsoleLogger>(), true);
+    benchLogger("ConsoleLogger (/dev/null)", std::make_shared<slog::ConsoleLogger>(), true);
+    benchLogger("FileLogger (/dev/null)",
+                std::make_shared<slog::FileLogger>("/dev/null", slog::LogFileMode::APPEND), false, true);
+    {
+        // The same custom layout compiled and parsed at runtime
+        const auto compiled = std::make_shared<slog::FileLogger>("/dev/null", slog::LogFileMode::APPEND);
+        compiled->setPattern(slog::compilePattern<"{time:%H:%M:%S.%f} {level:>7} {file}:{line} {msg}{fields}\n">());
+        benchLogger("FileLogger compiled pattern (/dev/null)", compiled, false, true);
+
+        const auto parsed = std::make_shared<slog::FileLogger>("/dev/null", slog::LogFileMode::APPEND);
+        parsed->setPattern(slog::PatternLayout("{time:%H:%M:%S.%f} {level:>7} {file}:{line} {msg}{fields}\n"));
+        benchLogger("FileLogger runtime pattern (/dev/null)", parsed, false, true);
+    }
+    benchLogger("FileLogger (tmpfs)", std::make_shared<slog::FileLogger>(plainFile, slog::LogFileMode::OVERWRITE),
+                false);
+    {
+        const auto buffered = std::make_shared<slog::FileLogger>(bufferedFile, slog::LogFileMode::OVERWRITE);
+        buffered->setFlushPolicy({.mode = slog::FlushMode::BUFFERED});
+        benchLogger("FileLogger buffered (tmpfs)", buffered, false);
+    }
+    benchLogger("BinaryFileLogger (tmpfs)",
+                std::make_shared<slog::BinaryFileLogger>(binaryFile, slog::LogFileMode::OVERWRITE), false);
+    benchLogger("JsonFileLogger (tmpfs)",
+                std::make_shared<slog::JsonFileLogger>(jsonFile, slog::LogFileMode::OVERWRITE), false);
+    benchLogger("LogfmtFileLogger (tmpfs)",
+                std::make_shared<slog::LogfmtFileLogger>(logfmtFile, slog::LogFileMode::OVERWRITE), false);
+    benchLogger("RepeatFilter + FileLogger (tmpfs)",
+                std::make_shared<slog::RepeatFilter>(
+                        std::make_shared<slog::FileLogger>(filteredFile, slog::LogFileMode::OVERWRITE)),
+                false);
+    if (slog::CompressedFileLogger::codecAvailable(slog::CompressionCodec::GZIP))
+    {
+        benchLogger("CompressedFileLogger gzip (tmpfs)",
+                    std::make_shared<slog::CompressedFileLogger>(compressedFile, slog::CompressionOptions{},
+                                                                 slog::LogFileMode::OVERWRITE),
+                    false);
+    }
+
+#ifndef _WIN32
+    const std::string mmapFile = benchFile("mmap.log");
+    const std::string flightFile = benchFile("flight.bin");
+
+    benchLogger("MmapFileLogger (tmpfs)", std::make_shared<slog::MmapFileLogger>(mmapFile, 16 * 1024 * 1024), false);
+    benchLogger("FlightRecorder (tmpfs)", std::make_shared<slog::FlightRecorder>(flightFile), false);
+#endif // _WIN32
+
+    // Producers sharing one logger, synchronously every thread writes itself
+    {
+        const auto buffered = std::make_shared<slog::FileLogger>(bufferedFile, slog::LogFileMode::OVERWRITE);
+        buffered->setFlushPolicy({.mode = slog::FlushMode::BUFFERED});
+        logger->clearLoggers();
+        logger->addLogger(buffered);
+
+        for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            report(throughput("SL_LOGD_INFO buffered file (" + std::to_string(threads) + " threads)", threads,
+                              s_sinkIterations / threads,
+                              [](const uint64_t i) { SL_LOGD_INFO("Request {} took {} us", i, i * 3); },
+                              [logger] { logger->flush(); }));
+        }
+    }
+
+    // Cost on the calling thread once records are handed to the backend
+    logger->clearLoggers();
+    logger->addLogger(std::make_shared<NullLogger>());
+    logger->startAsync(s_writeIterations);
+
+    report("SL_LOG_INFO with concatenation (async)",
+           nsPerOp(s_writeIterations,
+                   [](const uint64_t i)
+                   { SL_LOG_INFO("Request " + std::to_string(i) + " took " + std::to_string(i * 3) + " us"); }));
+    logger->flush();
+
+#ifdef SL_ENABLE_STD_FORMAT
+    report("SL_LOGF_INFO (async)",
+           nsPerOp(s_writeIterations, [](const uint64_t i) { SL_LOGF_INFO("Request {} took {} us", i, i * 3); }));
+    logger->flush();
+#endif // SL_ENABLE_STD_FORMAT
+
+    for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        report(throughput("SL_LOGD_INFO (async, " + std::to_string(threads) + " threads)", threads,
+                          s_writeIterations / threads,
+                          [](const uint64_t i) { SL_LOGD_INFO("Request {} took {} us", i, i * 3); },
+                          [logger] { logger->flush(); }));
+    }
+
+    {
+        const auto buffered = std::make_shared<slog::FileLogger>(bufferedFile, slog::LogFileMode::OVERWRITE);
+        buffered->setFlushPolicy({.mode = slog::FlushMode::BUFFERED});
+        logger->clearLoggers();
+        logger->addLogger(buffered);
+
+        for (uint32_t threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            report(throughput("SL_LOGD_INFO buffered file (async, " + std::to_string(threads) + " threads)", threads,
+                              s_writeIterations / threads,
+                              [](const uint64_t i) { SL_LOGD_INFO("Request {} took {} us", i, i * 3); },
+                              [logger] { logger->flush(); }));
+        }
+
+        logger->clearLoggers();
+        logger->addLogger(std::make_shared<NullLogger>());
+    }
+
+    reportAllocations("SL_LOGD_INFO (async)",
+                      allocationsPerOp(s_writeIterations, [](const uint64_t i)
+                                       { SL_LOGD_INFO("Request {} took {} us from {}", i, i * 3, "host"); },
+                                       [logger] { logger->flush(); }));
+
+    logger->shutdown();
+    logger->clearLoggers();
+
+    for (const auto &file: {plainFile, bufferedFile, binaryFile, jsonFile, logfmtFile, filteredFile, compressedFile})
+        removeBenchFiles(file);
+#ifndef _WIN32
+    removeBenchFiles(mmapFile);
+    removeBenchFiles(flightFile);
+#endif // _WIN32
+
+    if (s_format != OutputFormat::TEXT)
+    {
+        const std::string results = s_format == OutputFormat::JSON ? formatJson() : formatCsv();
+
+        if (output.empty())
+        {
+            std::cout << results;
+        }
+        else
+        {
+            std::ofstream file(output);
+            file << results;
+        }
+    }
+
+    const bool allocationFree = std::ranges::none_of(
+            s_results, [](const Result &result) { return result.mustNotAllocate and result.allocsPerOp > 0; });
+
+    return allocationFree ? 0 : 1;
+}
@@ -106,9 +106,41 @@ int main(const int argc, char *argv[])
     }
 
     // Sort the vector
+    const auto sortStart = std::chrono::steady_clock::now();
     std::ranges::sort(testVector);
+    const auto sortTime = std::chrono::steady_clock::now() - sortStart;
 
-    SL_LOG_INFO("Finished test for sorting vector");
+    SL_LOG_INFO_KV("Finished test for sorting vector", "elements", testVector.size(), "duration_us",
+                   std::chrono::duration_cast<std::chrono::microseconds>(sortTime).count());
+
+    // Categories have their own levels, "example.sort" only writes warnings and above
+    slog::Category::get("example.sort").setLevel(slog::LogLevel::WARNING);
+    SL_LOG_INFO_CAT(SL_CATEGORY("example.sort"), "This is hidden by the category level");
+    SL_LOGD_WARNING_CAT(SL_CATEGORY("example.sort"), "Sorted {} elements", testVector.size());
+
+    SL_LOG_INFO("Switching to asynchronous logging");
+    // Under load debug and info records are dropped (and counted) before errors ever have to wait
+    slog::SimpleLogger::GlobalLogger()->setBackpressure({.policy = slog::BackpressurePolicy::DROP_BELOW_LEVEL,
+                                                         .dropBelow = slog::LogLevel::WARNING});
+    slog::SimpleLogger::GlobalLogger()->startAsync();
+
+    for (int i = 0; i < 1000; i++)
+    {
+        SL_LOG_DEBUG("This is an asynchronous debug message");
+    }
+
+    for (int i = 0; i < 1000; i++)
+    {
+        SL_LOGD_WARNING_LIMITED(slog::RateLimit::firstThenSample(3, 250), "Rate limited warning {}", i);
+    }
+    slog::CallSiteLimiter::summarizeAll(true);
+
+    slog::SimpleLogger::GlobalLogger()->flush();
+    SL_LOG_INFO("Finished asynchronous logging");
+    slog::SimpleLogger::GlobalLogger()->shutdown();
+
+    // Write what the loggers did to the debug log
+    slog::logMetrics(*slog::SimpleLogger::GlobalLogger()->getLogger(2), slog::SimpleLogger::GlobalLogger()->metrics());
 
     return 0;
 }
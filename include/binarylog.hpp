@@ -0,0 +1,95 @@
+/**
+ * @brief Compact binary log files and reading them back
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+/*
+ * Binary log layout, all integers in native byte order:
+ *   header  "SLOGBIN1" u32 0x01020304          (again after every open or rotation, resets the format table)
+ *   format  u8 1, u32 id, varint length, bytes (each distinct format string once per file)
+ *   record  u8 2, i8 level, i64 unix time in ns, u32 thread id, u8 thread name length, thread name, u32 format id,
+ *           varint payload length, payload, varint fields length, fields
+ * Plain messages use format id 0 and store the message as the payload, deferred messages (SL_LOGD_*) store their
+ * arguments as [u8 ArgType][value] with integers as (zigzag) varints and strings as varint length + bytes. Key-value
+ * fields (SL_LOG_*_KV) are stored the same way as arguments.
+ */
+constexpr std::array<char, 8> BINARY_LOG_MAGIC = {'S', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+constexpr uint32_t BINARY_LOG_BYTE_ORDER = 0x01020304;
+constexpr uint32_t PLAIN_MESSAGE_FORMAT_ID = 0;
+
+enum class BinaryEntry : uint8_t
+{
+    FORMAT = 1,
+    RECORD = 2,
+    HEADER = 'S'
+};
+
+/** FileLogger writing the binary layout above, use slog-decode to turn it back into text */
+class BinaryFileLogger final : public FileLogger
+{
+public:
+    BinaryFileLogger();
+    explicit BinaryFileLogger(const std::string &filename, LogFileMode mode = LogFileMode::APPEND);
+
+    /* Deferred messages are stored unformatted */
+    [[nodiscard]] bool needsFormattedMessage() const override { return false; }
+
+protected:
+    void formatRecord(std::string &out, const LogRecord &record) override;
+    void beginFile(std::string &out) override;
+
+private:
+    struct FormatEntry
+    {
+        uint32_t id = PLAIN_MESSAGE_FORMAT_ID;
+        std::string format;
+    };
+
+    /* Keyed by the format string's address, the stored copy catches a different string at a reused address */
+    std::unordered_map<const char *, FormatEntry> m_formatIds;
+    uint32_t m_nextFormatId = PLAIN_MESSAGE_FORMAT_ID + 1;
+    std::string m_payload;
+};
+
+/** Reads the records of a file written by BinaryFileLogger */
+class BinaryLogReader
+{
+public:
+    explicit BinaryLogReader(const std::string &filename) noexcept(false);
+
+    /**
+     * Reads the next record with its message formatted, false at the end of the file or at a cut off record
+     * A length field pointing past the end of the file counts as cut off, so a corrupt one can't allocate more than
+     * the file holds. record.format points into the reader's format table and is only valid until the next call.
+     */
+    bool next(LogRecord &record) noexcept(false);
+
+private:
+    std::ifstream m_file;
+    std::string m_filename;
+    uint64_t m_fileSize = 0;
+    std::unordered_map<uint32_t, std::string> m_formats;
+    std::string m_payload;
+    std::string m_fields;
+    std::string m_arguments;
+
+    void readHeader() noexcept(false);
+    /** Whether length bytes are left in the file after the read position */
+    bool fitsInFile(uint64_t length);
+};
+
+} // namespace slog
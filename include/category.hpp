@@ -0,0 +1,93 @@
+/**
+ * @brief Named, hierarchical logging categories with their own levels
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logrecord.hpp"
+
+namespace slog
+{
+
+/**
+ * A named part of the program ("net.http") whose records can have a different level than everything else
+ * Names are dotted paths, "net.http" inherits the level of "net", which inherits the level of the root category, which
+ * follows the global logger's min/max levels. Setting a level on a category applies it to every category below it
+ * that hasn't set one itself.
+ *
+ *     static slog::Category &http = slog::Category::get("net.http");
+ *     slog::Category::get("net").setLevel(slog::LogLevel::DEBUG); // Debug output for net.* only
+ *     SL_LOGD_DEBUG_CAT(http, "Request {} sent", id);
+ *
+ * Every category keeps its enabled levels (its own range combined with the levels any logger writes) in one atomic, so
+ * checking a level is a single relaxed load. Categories are never destroyed, handles can be kept for good.
+ */
+class Category
+{
+public:
+    Category(const Category &) = delete;
+    Category &operator=(const Category &) = delete;
+
+    /** The category with this name, created (with its parents) on first use, look it up once and keep the handle */
+    static Category &get(std::string_view name);
+    /** The unnamed category every other one descends from */
+    static Category &root();
+
+    /** Whether a record of this level in this category would be written, a single relaxed load */
+    [[nodiscard]] bool isEnabled(const LogLevel level) const
+    {
+        return (m_enabledLevels.load(std::memory_order_relaxed) & levelBit(level)) != 0;
+    }
+
+    /** Write records from this level up (until the global max level) in this category and the ones below it */
+    void setLevel(LogLevel level);
+    /** Go back to inheriting the level of the parent category */
+    void inheritLevel();
+    /** The level records need to reach, set on this category or inherited */
+    [[nodiscard]] LogLevel getLevel() const { return m_effectiveLevel.load(std::memory_order_relaxed); }
+    /** Whether the level was set on this category rather than inherited */
+    [[nodiscard]] bool hasOwnLevel() const;
+
+    [[nodiscard]] std::string_view name() const { return m_name; }
+    /** nullptr for the root category */
+    [[nodiscard]] Category *parent() const { return m_parent; }
+
+    /** Called by the global SimpleLogger whenever its levels or the levels of its loggers change */
+    static void updateGlobalLevels(uint8_t loggerLevels, LogLevel minLevel, LogLevel maxLevel);
+
+private:
+    Category(std::string name, Category *parent);
+
+    const std::string m_name;
+    Category *const m_parent;
+
+    std::atomic<uint8_t> m_enabledLevels = 0;
+    std::atomic<LogLevel> m_effectiveLevel = LogLevel::DEBUG;
+
+    /* Guarded by the registry's mutex */
+    std::vector<Category *> m_children;
+    std::optional<LogLevel> m_level;
+
+    /* Recomputes the levels of this category and everything below it, the caller holds the registry's mutex */
+    void update();
+
+    friend struct CategoryRegistry;
+};
+
+} // namespace slog
+
+/** The category with this name, looked up once per call site, SL_LOG_DEBUG_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_CATEGORY(name)                                                                                              \
+    ([]() -> slog::Category &                                                                                          \
+     {                                                                                                                 \
+         static slog::Category &sl_category = slog::Category::get(name);                                               \
+         return sl_category;                                                                                           \
+     }())
@@ -0,0 +1,137 @@
+/**
+ * @brief Log files compressed while they're written
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+enum class CompressionCodec : uint8_t
+{
+    GZIP, /* Needs zlib at build time, every block is a gzip member ("app.log.gz", zcat reads the file) */
+    ZSTD, /* Needs libzstd at build time, every block is a zstd frame ("app.log.zst", zstdcat reads the file) */
+    LZ4   /* Needs liblz4 at build time, every block is an LZ4 frame ("app.log.lz4", lz4cat reads the file) */
+};
+
+constexpr std::size_t DEFAULT_COMPRESSED_BLOCK_SIZE = 256 * 1024;
+/* Finished blocks waiting for the compression thread before logging has to wait for it */
+constexpr std::size_t MAX_PENDING_COMPRESSED_BLOCKS = 4;
+
+/** How CompressedFileLogger cuts its output into blocks */
+struct CompressionOptions
+{
+    CompressionCodec codec = CompressionCodec::GZIP;
+    /* Codec specific, 0 uses the codec's default */
+    int level = 0;
+    /* Uncompressed bytes per block, bigger blocks compress better but more is lost in a crash */
+    std::size_t blockSize = DEFAULT_COMPRESSED_BLOCK_SIZE;
+    /* Finish the current block once its first record is this old, 0 disables it */
+    std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1000);
+    /* Records at or above this level finish the current block right away */
+    LogLevel flushLevel = LogLevel::ERROR;
+};
+
+/* Compresses one block into a complete, independent frame of a codec, see compressedlog.cpp */
+class BlockCompressor;
+
+/** Totals of a CompressedFileLogger since it was created */
+struct CompressionStats
+{
+    uint64_t blocks = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    /* Blocks the codec failed to compress or the file failed to take and the records in them, they're lost (also
+     * counted as dropped metrics) */
+    uint64_t failedBlocks = 0;
+    uint64_t droppedRecords = 0;
+};
+
+/**
+ * Writes lines like FileLogger into a compressed file, in blocks that can each be decompressed on their own
+ * Records are formatted into the current block, finished blocks are compressed and written on a background thread,
+ * so logging only pays for formatting. A block is finished when it's full, on the flush interval or level and on
+ * flush(), which waits until it's on disk. A crash loses at most the block being filled (and the few waiting for the
+ * compression thread), everything before it is a complete gzip member / zstd frame / LZ4 frame the usual tools read.
+ */
+class CompressedFileLogger final : public LoggerLoc
+{
+public:
+    CompressedFileLogger();
+    explicit CompressedFileLogger(const std::string &filename, const CompressionOptions &options = {},
+                                  LogFileMode mode = LogFileMode::APPEND) noexcept(false);
+    ~CompressedFileLogger() override;
+
+    /** Throws slog::LogException if the file can't be opened or the codec wasn't available at build time */
+    void openFile(const std::string &filename, const CompressionOptions &options = {},
+                  LogFileMode mode = LogFileMode::APPEND) noexcept(false);
+    void closeFile();
+
+    void log(const std::string &message, LogLevel level) override;
+    void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    void flush() override;
+    void poll() override;
+
+    /** Layout of each line, DEFAULT_FILE_PATTERN by default */
+    void setPattern(const PatternLayout &pattern);
+    [[nodiscard]] PatternLayout getPattern();
+
+    [[nodiscard]] CompressionStats getStats();
+
+    /** Whether SimpleLogger was built with the library the codec needs */
+    static bool codecAvailable(CompressionCodec codec);
+
+private:
+    /* Guards the block being filled and everything else the logging side uses */
+    std::mutex m_mutex;
+    CompressionOptions m_options;
+    PatternLayout m_pattern = compilePattern<DEFAULT_FILE_PATTERN>();
+    std::string m_block;
+    uint64_t m_blockRecords = 0;
+    std::chrono::steady_clock::time_point m_blockStarted;
+    bool m_open = false;
+
+    /* Guards everything below, shared with the compression thread */
+    std::mutex m_queueMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    struct PendingBlock
+    {
+        std::string data;
+        uint64_t records = 0;
+    };
+
+    std::deque<PendingBlock> m_pending;
+    /* Strings of written blocks, reused so their capacity isn't allocated again */
+    std::vector<std::string> m_spare;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::ofstream m_file;
+    std::unique_ptr<BlockCompressor> m_compressor;
+    CompressionStats m_stats;
+    std::thread m_thread;
+
+    /* Caller holds m_mutex, hands the current block to the compression thread */
+    void finishBlock();
+    /* Caller holds m_mutex, waits until every finished block is written */
+    void waitForBlocks();
+    void run();
+};
+
+} // namespace slog
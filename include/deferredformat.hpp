@@ -0,0 +1,381 @@
+/**
+ * @brief Capturing format arguments at the call site so formatting can happen on the backend
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <version>
+
+#ifdef __cpp_lib_format
+#include <format>
+#endif // __cpp_lib_format
+
+namespace slog
+{
+
+/* Limit on the number of arguments a deferred message can capture */
+constexpr std::size_t MAX_DEFERRED_ARGUMENTS = 32;
+
+/* Tag written in front of every encoded argument */
+enum class ArgType : uint8_t
+{
+    BOOL,
+    CHAR,
+    INT64,
+    UINT64,
+    DOUBLE,
+    STRING,
+    POINTER
+};
+
+/**
+ * Appends the arguments to out as [tag][value] pairs
+ * Numbers are memcpy'd as 64 bit values, strings are copied as [u32 length][bytes] so the caller's buffers can go away
+ */
+inline void encodeArguments(std::string &) {}
+
+template<typename T, typename... Args>
+void encodeArguments(std::string &out, const T &value, const Args &...args);
+
+namespace detail
+{
+
+template<typename T>
+void appendRaw(std::string &out, const T &value)
+{
+    const auto size = out.size();
+    out.resize(size + sizeof(T));
+    std::memcpy(out.data() + size, &value, sizeof(T));
+}
+
+inline void appendString(std::string &out, const std::string_view value)
+{
+    out.push_back(static_cast<char>(ArgType::STRING));
+    appendRaw(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+/* The tag a value of T is captured with */
+template<typename T>
+consteval ArgType argumentType()
+{
+    using Type = std::remove_cvref_t<T>;
+
+    if constexpr (std::same_as<Type, bool>)
+        return ArgType::BOOL;
+    else if constexpr (std::same_as<Type, char>)
+        return ArgType::CHAR;
+    else if constexpr (std::signed_integral<Type>)
+        return ArgType::INT64;
+    else if constexpr (std::unsigned_integral<Type>)
+        return ArgType::UINT64;
+    else if constexpr (std::floating_point<Type>)
+        return ArgType::DOUBLE;
+    else if constexpr (std::convertible_to<const Type &, std::string_view>)
+        return ArgType::STRING;
+    else if constexpr (std::is_pointer_v<Type> or std::is_null_pointer_v<Type>)
+        return ArgType::POINTER;
+    else
+        static_assert(sizeof(Type) == 0, "Type can't be captured for deferred formatting, use SL_LOGF_* instead");
+}
+
+template<typename T>
+void encodeArgument(std::string &out, const T &value)
+{
+    using Type = std::remove_cvref_t<T>;
+    constexpr ArgType TYPE = argumentType<T>();
+
+    if constexpr (TYPE == ArgType::STRING)
+    {
+        // A null C string can't become a string_view
+        if constexpr (std::is_pointer_v<Type>)
+            appendString(out, value != nullptr ? std::string_view(value) : std::string_view("(null)"));
+        else
+            appendString(out, std::string_view(value));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(TYPE));
+        if constexpr (TYPE == ArgType::BOOL)
+            out.push_back(value ? 1 : 0);
+        else if constexpr (TYPE == ArgType::CHAR)
+            out.push_back(value);
+        else if constexpr (TYPE == ArgType::INT64)
+            appendRaw(out, static_cast<int64_t>(value));
+        else if constexpr (TYPE == ArgType::UINT64)
+            appendRaw(out, static_cast<uint64_t>(value));
+        else if constexpr (TYPE == ArgType::DOUBLE)
+            appendRaw(out, static_cast<double>(value));
+        else
+            appendRaw(out, reinterpret_cast<uint64_t>(static_cast<const void *>(value)));
+    }
+}
+
+/**
+ * Position of the '}' closing the replacement field that opens at format[open], npos if it isn't closed
+ * The spec may hold nested "{}" or "{n}" fields giving a dynamic width or precision, "{:{}}" or "{:.{}f}".
+ */
+constexpr std::size_t replacementFieldEnd(const std::string_view format, const std::size_t open)
+{
+    for (std::size_t i = open + 1; i < format.size(); i++)
+    {
+        if (format[i] == '}')
+            return i;
+
+        if (format[i] == '{')
+        {
+            i = format.find('}', i);
+            if (i == std::string_view::npos)
+                break;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+/* Argument ids handed out so far while checking a format string */
+struct ArgumentIds
+{
+    std::span<const ArgType> types;
+    std::size_t next = 0;
+    bool automatic = false;
+    bool manual = false;
+};
+
+/* Reads the argument id at text[position], without digits it's the next automatic one */
+consteval std::size_t readArgumentId(const std::string_view text, std::size_t &position, ArgumentIds &ids)
+{
+    std::size_t index = 0;
+    if (position < text.size() and text[position] >= '0' and text[position] <= '9')
+    {
+        while (position < text.size() and text[position] >= '0' and text[position] <= '9')
+            index = index * 10 + static_cast<std::size_t>(text[position++] - '0');
+
+        ids.manual = true;
+    }
+    else
+    {
+        index = ids.next++;
+        ids.automatic = true;
+    }
+
+    if (ids.automatic and ids.manual)
+        throw "Format string mixes automatic and manual argument indexing";
+    if (index >= ids.types.size())
+        throw "Format string references more arguments than were given";
+
+    return index;
+}
+
+/* Reads a width or precision, either digits or a nested field naming an integer argument */
+consteval bool readCount(const std::string_view spec, std::size_t &position, ArgumentIds &ids)
+{
+    if (position < spec.size() and spec[position] == '{')
+    {
+        position++;
+        const std::size_t index = readArgumentId(spec, position, ids);
+        if (position >= spec.size() or spec[position] != '}')
+            throw "Invalid argument id in format string";
+        if (ids.types[index] != ArgType::INT64 and ids.types[index] != ArgType::UINT64)
+            throw "Dynamic width or precision in format string isn't an integer argument";
+
+        position++;
+        return true;
+    }
+
+    const std::size_t start = position;
+    while (position < spec.size() and spec[position] >= '0' and spec[position] <= '9')
+        position++;
+
+    return position != start;
+}
+
+/**
+ * Checks a spec the way std::formatter of the argument's type parses it
+ * [[fill]align][sign][#][0][width][.precision][L][type], with the presentation types and options the standard
+ * allows for that type.
+ */
+consteval void checkFormatSpec(const std::string_view spec, const ArgType type, ArgumentIds &ids)
+{
+    const auto isAlign = [](const char c) { return c == '<' or c == '>' or c == '^'; };
+    const auto isOneOf = [](const char c, const std::string_view options)
+    { return c != '\0' and options.find(c) != std::string_view::npos; };
+
+    std::size_t position = 0;
+    if (spec.size() >= 2 and isAlign(spec[1]))
+    {
+        if (spec[0] == '{' or spec[0] == '}')
+            throw "Invalid fill character in format string";
+        position = 2;
+    }
+    else if (!spec.empty() and isAlign(spec[0]))
+    {
+        position = 1;
+    }
+
+    const bool sign = position < spec.size() and isOneOf(spec[position], "+- ");
+    position += sign ? 1 : 0;
+    const bool alternate = position < spec.size() and spec[position] == '#';
+    position += alternate ? 1 : 0;
+    const bool zeroPad = position < spec.size() and spec[position] == '0';
+    position += zeroPad ? 1 : 0;
+
+    readCount(spec, position, ids);
+
+    const bool precision = position < spec.size() and spec[position] == '.';
+    if (precision)
+    {
+        position++;
+        if (!readCount(spec, position, ids))
+            throw "Missing precision in format string";
+    }
+
+    const bool locale = position < spec.size() and spec[position] == 'L';
+    position += locale ? 1 : 0;
+
+    const char presentation = position < spec.size() ? spec[position++] : '\0';
+    if (position != spec.size())
+        throw "Invalid format spec in format string";
+
+    constexpr std::string_view INTEGER_TYPES = "bBdoxX";
+    bool numeric = true;
+    switch (type)
+    {
+        case ArgType::BOOL:
+            if (presentation != '\0' and presentation != 's' and !isOneOf(presentation, INTEGER_TYPES))
+                throw "Invalid presentation type for a bool in format string";
+            numeric = isOneOf(presentation, INTEGER_TYPES);
+            break;
+        case ArgType::CHAR:
+            if (presentation != '\0' and !isOneOf(presentation, "c?") and !isOneOf(presentation, INTEGER_TYPES))
+                throw "Invalid presentation type for a char in format string";
+            numeric = isOneOf(presentation, INTEGER_TYPES);
+            break;
+        case ArgType::INT64:
+        case ArgType::UINT64:
+            if (presentation != '\0' and presentation != 'c' and !isOneOf(presentation, INTEGER_TYPES))
+                throw "Invalid presentation type for an integer in format string";
+            break;
+        case ArgType::DOUBLE:
+            if (presentation != '\0' and !isOneOf(presentation, "aAeEfFgG"))
+                throw "Invalid presentation type for a floating point value in format string";
+            break;
+        case ArgType::STRING:
+            if (presentation != '\0' and !isOneOf(presentation, "s?"))
+                throw "Invalid presentation type for a string in format string";
+            numeric = false;
+            break;
+        case ArgType::POINTER:
+            if (presentation != '\0' and presentation != 'p')
+                throw "Invalid presentation type for a pointer in format string";
+            numeric = false;
+            break;
+    }
+
+    if (!numeric and (sign or alternate or zeroPad))
+        throw "Sign, '#' and '0' in format string need a numeric presentation";
+    if ((type == ArgType::STRING or type == ArgType::POINTER) and locale)
+        throw "'L' in format string needs an arithmetic argument";
+    if (precision and type != ArgType::DOUBLE and type != ArgType::STRING)
+        throw "Precision in format string needs a floating point or string argument";
+}
+
+/* Validates a format string at compile time, throwing makes the consteval constructor ill-formed */
+consteval void checkFormatString(const std::string_view format, const std::span<const ArgType> types)
+{
+    ArgumentIds ids{types};
+
+    for (std::size_t i = 0; i < format.size(); i++)
+    {
+        if (format[i] == '}')
+        {
+            if (i + 1 >= format.size() or format[i + 1] != '}')
+                throw "Unmatched '}' in format string";
+
+            i++;
+            continue;
+        }
+
+        if (format[i] != '{')
+            continue;
+
+        if (i + 1 < format.size() and format[i + 1] == '{')
+        {
+            i++;
+            continue;
+        }
+
+        const std::size_t close = replacementFieldEnd(format, i);
+        if (close == std::string_view::npos)
+            throw "Unmatched '{' in format string";
+
+        std::size_t position = i + 1;
+        const std::size_t index = readArgumentId(format, position, ids);
+        if (position != close and format[position] != ':')
+            throw "Invalid argument id in format string";
+
+        if (position != close)
+            checkFormatSpec(format.substr(position + 1, close - position - 1), types[index], ids);
+
+        i = close;
+    }
+}
+
+} // namespace detail
+
+template<typename T, typename... Args>
+void encodeArguments(std::string &out, const T &value, const Args &...args)
+{
+    detail::encodeArgument(out, value);
+    encodeArguments(out, args...);
+}
+
+/**
+ * Format string checked at compile time like std::format_string checks SL_LOGF_*, argument ids and counts and each
+ * spec against the type of its argument. Only used when the standard library doesn't provide <format>, then format
+ * specs are handled by formatDeferred.
+ */
+template<typename... Args>
+class BasicDeferredFormatString
+{
+public:
+    template<typename String>
+        requires std::convertible_to<const String &, std::string_view>
+    consteval BasicDeferredFormatString(const String &format) : m_format(format) // NOLINT(*-explicit-constructor)
+    {
+        constexpr std::array<ArgType, sizeof...(Args)> TYPES{detail::argumentType<Args>()...};
+        detail::checkFormatString(m_format, TYPES);
+    }
+
+    [[nodiscard]] constexpr std::string_view get() const { return m_format; }
+
+private:
+    std::string_view m_format;
+};
+
+#ifdef __cpp_lib_format
+template<typename... Args>
+using DeferredFormatString = std::format_string<Args...>;
+#else
+template<typename... Args>
+using DeferredFormatString = BasicDeferredFormatString<std::type_identity_t<Args>...>;
+#endif // __cpp_lib_format
+
+/**
+ * Formats the encoded arguments into out using the format string
+ * Supports automatic and manual argument ids and the standard format spec for every captured type, with nested
+ * fields for a dynamic width or precision.
+ */
+void formatDeferred(std::string &out, std::string_view format, std::string_view arguments);
+
+} // namespace slog
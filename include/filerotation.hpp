@@ -0,0 +1,69 @@
+/**
+ * @brief Background work for rotated log files
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace slog
+{
+
+/**
+ * Names rotated files, compresses them and removes the ones past the retention limit, so FileLogger only has to move
+ * the file it was writing to out of the way and open a new one. Shared by every rotating FileLogger and kept alive by
+ * them.
+ */
+class RotationWorker
+{
+public:
+    struct Job
+    {
+        /* The file that was just rotated out, under a temporary name */
+        std::filesystem::path rotatedFile;
+        /* The file the logger keeps writing to, rotated files are named after it */
+        std::filesystem::path activeFile;
+        /* ".<yyyymmdd-hhmmss>" of the rotation, the rotated file becomes "<active file><suffix>[.n]" */
+        std::string suffix;
+        uint32_t maxFiles = 0;
+        bool compress = false;
+    };
+
+    static std::shared_ptr<RotationWorker> instance();
+
+    RotationWorker();
+    ~RotationWorker();
+
+    RotationWorker(const RotationWorker &) = delete;
+    RotationWorker &operator=(const RotationWorker &) = delete;
+
+    void schedule(Job job);
+    /** Wait until every scheduled job has finished */
+    void wait();
+
+    /** Whether rotated files can be compressed, requires zlib at build time */
+    static bool compressionAvailable();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Job> m_jobs;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    void run();
+    static void process(const Job &job);
+};
+
+} // namespace slog
@@ -0,0 +1,88 @@
+/**
+ * @brief Crash-surviving ring of recent records kept in a shared file mapping
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#ifndef _WIN32
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+constexpr std::size_t DEFAULT_FLIGHT_RECORDER_SLOTS = 4096;
+/* Bytes per record including its 40 byte header, longer messages are cut off */
+constexpr std::size_t DEFAULT_FLIGHT_RECORDER_SLOT_SIZE = 256;
+/* Recorders alive at the same time that the crash handlers know about */
+constexpr std::size_t MAX_FLIGHT_RECORDERS = 8;
+
+constexpr std::array<char, 8> FLIGHT_RECORDER_MAGIC = {'S', 'L', 'O', 'G', 'F', 'L', 'T', '1'};
+
+/**
+ * Always-on recording of the last records (DEBUG included by default) into a MAP_SHARED file, e.g. under /dev/shm
+ * Nothing is written to disk in the normal case, but the pages outlive the process: after a SIGKILL or a crash the
+ * file (or a core containing the mapping) can be read with slog-recover. On SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT
+ * and from the CaptureExceptions terminate handler every live recorder is also written to stderr, using only
+ * async-signal-safe calls. Slots are claimed with one atomic increment and guarded by a sequence number, so a record
+ * being written while the process dies is skipped instead of read torn.
+ */
+class FlightRecorder final : public LoggerLoc
+{
+public:
+    /** Creates (or truncates) the file, removeOnClose deletes it again on a clean shutdown */
+    explicit FlightRecorder(const std::string &filename, std::size_t slotCount = DEFAULT_FLIGHT_RECORDER_SLOTS,
+                            std::size_t slotSize = DEFAULT_FLIGHT_RECORDER_SLOT_SIZE,
+                            bool removeOnClose = true) noexcept(false);
+    ~FlightRecorder() override;
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    void log(const std::string &message, LogLevel level) override;
+    void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+
+    /** Writes the recorded records oldest first as text to fd, async-signal-safe */
+    void dump(int fd) const noexcept;
+
+    /** Dumps every live recorder once, later calls do nothing (the terminate handler and SIGABRT both get here) */
+    static void dumpAll(int fd) noexcept;
+
+    /**
+     * Gives the calling thread an alternate signal stack, so the crash handlers still run after a stack overflow
+     * Does nothing before the first recorder installs the handlers. Done for the thread creating a recorder, threads
+     * logging to one and every thread's first record through SimpleLogger, call it for other threads.
+     */
+    static void prepareThread() noexcept;
+
+    /** Reads the records left in a recorder file or a core dump containing one, oldest first */
+    static std::vector<LogRecord> recover(const std::string &filename) noexcept(false);
+
+private:
+    struct Header;
+    struct Slot;
+
+    std::string m_filename;
+    bool m_removeOnClose;
+    std::size_t m_slotSize;
+    std::size_t m_slotCount;
+    std::size_t m_mappingSize = 0;
+
+    char *m_mapping = nullptr;
+    Header *m_header = nullptr;
+
+    [[nodiscard]] Slot *slot(uint64_t sequence) const;
+};
+
+} // namespace slog
+
+#endif // _WIN32
@@ -0,0 +1,135 @@
+/**
+ * @brief Levels, file loggers and flush policies from a config file, reloaded while the program runs
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+class SimpleLogger;
+
+/* How often the watcher checks the file where there is no inotify, and how long it waits to notice stop() with it */
+constexpr auto CONFIG_POLL_INTERVAL = std::chrono::milliseconds(500);
+
+/** Levels and flush policy for one logger, whatever isn't set is left alone */
+struct LoggerConfig
+{
+    std::optional<LogLevel> minLevel;
+    std::optional<LogLevel> maxLevel;
+    /* Only for FileLoggers and the console loggers */
+    std::optional<FlushPolicy> flushPolicy;
+};
+
+/** A FileLogger the config opens */
+struct FileConfig
+{
+    std::filesystem::path path;
+    LogFileMode mode = LogFileMode::APPEND;
+    LoggerConfig logger;
+};
+
+/**
+ * Parsed config file, comments start with # or ;
+ *
+ *     level = INFO              # Global min level, max_level sets the max level
+ *
+ *     [category net.http]       # See slog::Category
+ *     level = DEBUG
+ *
+ *     [logger console]          # The global logger's console logger, or one registered with ConfigWatcher
+ *     level = WARNING
+ *
+ *     [file app]                # A FileLogger the config owns, removed again once its section is gone
+ *     path = app.log
+ *     mode = append             # or overwrite
+ *     level = INFO
+ *     flush = buffered          # or always, then buffer_size, flush_bytes, flush_interval_ms and flush_level
+ *     flush_interval_ms = 500
+ *
+ * Levels are DEBUG, INFO, WARNING, ERROR or FATAL in any case.
+ */
+struct LogConfig
+{
+    std::optional<LogLevel> minLevel;
+    std::optional<LogLevel> maxLevel;
+    std::map<std::string, LogLevel, std::less<>> categories;
+    std::map<std::string, LoggerConfig, std::less<>> loggers;
+    std::map<std::string, FileConfig, std::less<>> files;
+
+    /** Throws slog::LogException naming the line for anything it doesn't understand */
+    static LogConfig parse(std::string_view text) noexcept(false);
+    /** Reads and parses a file, throws slog::LogException if it can't be read or parsed */
+    static LogConfig load(const std::filesystem::path &path) noexcept(false);
+};
+
+/**
+ * Applies a config file to a SimpleLogger and reapplies it whenever the file changes (inotify on Linux)
+ *
+ *     slog::ConfigWatcher watcher("logging.conf");
+ *     watcher.start();
+ *
+ * A new version is parsed completely before anything is applied, an invalid one is reported through the logger and
+ * the previous config stays in place. Applying only stores atomic levels and swaps the logger list (see
+ * SinkRegistry), so logging threads never wait for a reload. Each setting switches atomically, but a reload isn't
+ * swapped in as a whole: while it's being applied a logging thread can see some of the new levels and not others yet
+ * (global levels first, then categories, loggers and files). Categories and files that disappear from the config go
+ * back to inheriting their level and are closed, global and logger settings that disappear are left as they are.
+ * Levels compiled out with SL_MIN_LOG_LEVEL can't be turned on from a config.
+ */
+class ConfigWatcher
+{
+public:
+    explicit ConfigWatcher(std::filesystem::path path, SimpleLogger *logger = nullptr);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    ConfigWatcher &operator=(const ConfigWatcher &) = delete;
+
+    /** Make a logger configurable as [logger name], the global logger's console logger is "console" */
+    void registerLogger(const std::string &name, const std::shared_ptr<LoggerLoc> &loggerLoc);
+
+    /** Read and apply the file now, returns false (and logs why) if it couldn't be read or parsed */
+    bool reload();
+    /** Apply the file (returns once it's applied), then keep applying it on a background thread whenever it changes */
+    void start();
+    void stop();
+
+    /** The config applied last, nullptr before the first successful reload */
+    [[nodiscard]] std::shared_ptr<const LogConfig> current() const;
+
+private:
+    std::filesystem::path m_path;
+    SimpleLogger *m_logger;
+
+    /* Guards everything below, reloads are applied one at a time */
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<LoggerLoc>, std::less<>> m_loggers;
+    std::map<std::string, std::shared_ptr<FileLogger>, std::less<>> m_files;
+    std::shared_ptr<const LogConfig> m_current;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stop = false;
+
+    /* Caller holds m_mutex */
+    void apply(const LogConfig &config);
+    void watch(std::promise<void> started);
+};
+
+} // namespace slog
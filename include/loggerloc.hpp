@@ -6,26 +6,26 @@
  */
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "logexception.hpp"
+#include "logindex.hpp"
+#include "loggermetrics.hpp"
+#include "logpattern.hpp"
+#include "logrecord.hpp"
 
 namespace slog
 {
 
-/* Enums for logger information */
-enum class LogLevel
-{
-    NONE = -1,
-    DEBUG = 0,
-    INFO,
-    WARNING,
-    ERROR,
-    FATAL
-};
-
 enum class LogFileMode
 {
     APPEND,
@@ -34,8 +34,68 @@ enum class LogFileMode
 
 constexpr uint32_t MAX_LOG_LEVEL_NAME_LENGTH = 7;
 
+enum class FlushMode
+{
+    ALWAYS,  /* Write every record as soon as it's logged */
+    BUFFERED /* Collect records and write them in groups, see FlushPolicy */
+};
+
+constexpr std::size_t DEFAULT_FILE_BUFFER_SIZE = 64 * 1024;
+
+/** When a FileLogger writes its buffered records to the file */
+struct FlushPolicy
+{
+    FlushMode mode = FlushMode::ALWAYS;
+
+    /* Size of the write buffer, it's written out whenever a record wouldn't fit anymore */
+    std::size_t bufferSize = DEFAULT_FILE_BUFFER_SIZE;
+    /* Write once this many bytes are buffered, 0 only writes when the buffer is full */
+    std::size_t flushBytes = 0;
+    /* Write records that have been buffered for this long, 0 disables it */
+    std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1000);
+    /* Records at or above this level are written immediately, together with everything buffered before them */
+    LogLevel flushLevel = LogLevel::ERROR;
+};
+
 std::string getLogName(LogLevel level);
 std::string formatStringFromLeft(const std::string &name, uint32_t size);
+/** Appends the record laid out by DEFAULT_FILE_PATTERN, "[dd/mm/yyyy hh:mm:ss.mmm   LEVEL]: message\n" */
+void formatLogLine(std::string &out, const LogRecord &record);
+/** Appends " [id name]" for records that know their thread, nothing otherwise */
+void formatThread(std::string &out, const LogRecord &record);
+/** Recomputes the enabled levels of every SimpleLogger, called whenever a LoggerLoc's levels change */
+void notifyLevelsChanged();
+
+enum class RotationInterval
+{
+    NONE,
+    HOURLY,
+    DAILY
+};
+
+/** When a FileLogger starts a new file, the old one is renamed to "<file>.<yyyymmdd-hhmmss>" */
+struct RotationPolicy
+{
+    /* Roll over before the file would grow past this many bytes, 0 disables it */
+    std::size_t maxBytes = 0;
+    /* Roll over on hour or day boundaries (in the time zone set with slog::setTimeZone) */
+    RotationInterval interval = RotationInterval::NONE;
+    /* Keep at most this many rotated files, 0 keeps all of them */
+    uint32_t maxFiles = 0;
+    /* gzip rotated files in the background, requires zlib */
+    bool compress = false;
+};
+
+/** How a FileLogger indexes its file in "<file>.idx" (see slog::LogIndexReader and slog-query), off by default */
+struct IndexPolicy
+{
+    bool enabled = false;
+    /* An index entry covers at most this many records and about this many bytes, 0 for no limit */
+    uint32_t records = 4096;
+    std::size_t bytes = 1024 * 1024;
+};
+
+class RotationWorker;
 
 /* Logger interface + sub classes */
 class LoggerLoc
@@ -48,14 +108,103 @@ public:
     virtual void log(const std::string &message, LogLevel level) = 0;
     virtual void exception(const LogException &exception) = 0;
 
-    void setMaxLogLevel(const LogLevel level) { m_maxLogLevel = level; }
-    void setMinLogLevel(const LogLevel level) { m_minLogLevel = level; }
+    /** Log a record produced by SimpleLogger, override this to use the record's timestamp instead of the write time */
+    virtual void logRecord(const LogRecord &record) { log(record.message, record.level); }
+    /** Write out anything the logger has buffered */
+    virtual void flush() {}
+    /** Called periodically by the asynchronous backend, for time based work like interval flushing */
+    virtual void poll() {}
+    /** Whether logRecord reads the message of deferred (SL_LOGD_*) records, if none does it's never formatted */
+    [[nodiscard]] virtual bool needsFormattedMessage() const { return true; }
+
+    void setMaxLogLevel(const LogLevel level)
+    {
+        m_maxLogLevel = level;
+        notifyLevelsChanged();
+    }
+    void setMinLogLevel(const LogLevel level)
+    {
+        m_minLogLevel = level;
+        notifyLevelsChanged();
+    }
+
+    [[nodiscard]] LogLevel getMaxLogLevel() const { return m_maxLogLevel; }
+    [[nodiscard]] LogLevel getMinLogLevel() const { return m_minLogLevel; }
+    /** Mask of the levels this logger writes, see slog::levelBit */
+    [[nodiscard]] uint8_t getEnabledLevels() const { return levelRangeMask(m_minLogLevel, m_maxLogLevel); }
+
+    /** Counters about this logger, SimpleLogger counts the records it passes in and the logger what it writes */
+    [[nodiscard]] SinkMetrics &metrics() const { return *m_metrics; }
 
 protected:
-    LogLevel m_maxLogLevel = LogLevel::FATAL;
-    LogLevel m_minLogLevel = LogLevel::INFO; // Default to INFO
+    std::atomic<LogLevel> m_maxLogLevel = LogLevel::FATAL;
+    std::atomic<LogLevel> m_minLogLevel = LogLevel::INFO; // Default to INFO
 
     [[nodiscard]] static std::string getTime();
+    [[nodiscard]] static std::string getTime(std::chrono::system_clock::time_point time);
+    /** The record's formatted timestamp, only formats it if SimpleLogger hasn't already */
+    [[nodiscard]] static FormattedTime getTime(const LogRecord &record);
+
+private:
+    /* Sharded per thread, a few kilobytes, so it lives on the heap */
+    std::unique_ptr<SinkMetrics> m_metrics = std::make_unique<SinkMetrics>();
+};
+
+enum class ConsoleStream : uint8_t
+{
+    STDOUT,
+    STDERR
+};
+
+/* Most lines a buffered console logger gathers into one writev, well below any IOV_MAX */
+constexpr std::size_t MAX_CONSOLE_BATCH_LINES = 64;
+
+/** Whether the stream is a terminal (isatty), checked once, colors and rewriting lines with \r only make sense there */
+bool isConsoleTerminal(ConsoleStream stream);
+/** Writes "SimpleLogger: <message>" to stderr, for a logger's failures that can't go into its own output */
+void reportLoggerError(std::string_view message);
+
+/**
+ * Writes the console loggers' lines straight to stdout and stderr, without iostreams
+ * With FlushMode::ALWAYS every line is a single write(2). Buffered, lines are built in reused strings and written
+ * together with one writev(2) whenever the FlushPolicy says so, or once a line for the other stream comes, so both
+ * streams stay in order. Not synchronized, the console loggers call it under their mutex.
+ */
+class ConsoleOutput
+{
+public:
+    explicit ConsoleOutput(SinkMetrics &metrics) : m_metrics(metrics) {}
+    ~ConsoleOutput();
+
+    ConsoleOutput(const ConsoleOutput &) = delete;
+    ConsoleOutput &operator=(const ConsoleOutput &) = delete;
+
+    /** Empty string to build the next line in, write() takes it afterward */
+    std::string &nextLine();
+    /** Write the line built in nextLine(), or keep it with the others until the flush policy writes them */
+    void write(ConsoleStream stream, LogLevel level);
+    /** Write every line kept so far */
+    void flush();
+    /** Write the kept lines once the oldest has waited for the policy's flush interval */
+    void poll();
+
+    /** Writes the kept lines, the buffer size caps how many bytes one writev carries */
+    void setFlushPolicy(const FlushPolicy &policy);
+    [[nodiscard]] const FlushPolicy &getFlushPolicy() const { return m_flushPolicy; }
+
+private:
+    SinkMetrics &m_metrics;
+    FlushPolicy m_flushPolicy;
+
+    /* The first m_pending lines wait to be written to m_stream, the rest are kept for their capacity */
+    std::vector<std::string> m_lines;
+    std::size_t m_pending = 0;
+    std::size_t m_pendingBytes = 0;
+    ConsoleStream m_stream = ConsoleStream::STDOUT;
+    std::chrono::steady_clock::time_point m_bufferedSince;
+
+    /* Writes the pending lines in one go */
+    void writePending();
 };
 
 class SimpleConsoleLogger final : public LoggerLoc
@@ -65,14 +214,35 @@ public:
 
     void log(const std::string &message, LogLevel level) override;
     void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    void flush() override;
+
+    void poll() override;
 
     void enableColor() { m_color = true; }
     void enableColor(const bool enable) { m_color = enable; }
     void disableColor() { m_color = false; }
     [[nodiscard]] bool isColorEnabled() const { return m_color; }
 
+    /** Colors are left out where the output isn't a terminal (the default), disable to always write them */
+    void enableTerminalDetection(const bool enable) { m_detectTerminal = enable; }
+    [[nodiscard]] bool isTerminalDetectionEnabled() const { return m_detectTerminal; }
+
+    /** Layout of each line, DEFAULT_CONSOLE_PATTERN by default */
+    void setPattern(const PatternLayout &pattern);
+    [[nodiscard]] PatternLayout getPattern();
+
+    /** Write every line right away (the default) or gather them, see ConsoleOutput */
+    void setFlushPolicy(const FlushPolicy &policy);
+    [[nodiscard]] FlushPolicy getFlushPolicy();
+
 private:
     bool m_color = false;
+    bool m_detectTerminal = true;
+    PatternLayout m_pattern = compilePattern<DEFAULT_CONSOLE_PATTERN>();
+
+    std::mutex m_mutex;
+    ConsoleOutput m_output{metrics()};
 };
 
 class ConsoleLogger final : public LoggerLoc
@@ -82,8 +252,15 @@ public:
 
     void log(const std::string &message, LogLevel level) override;
     void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    void flush() override;
+    void poll() override;
 
-    [[nodiscard]] uint32_t getRepeatCount() const { return m_repeatCount; }
+    [[nodiscard]] uint32_t getRepeatCount() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_repeatCount;
+    }
 
     void enableFullColor() { m_fullColor = true; }
     void enableFullColor(const bool enable) { m_fullColor = enable; }
@@ -95,18 +272,57 @@ public:
     void disableColor() { m_color = false; }
     [[nodiscard]] bool isColorEnabled() const { return m_color; }
 
+    /**
+     * Where the output isn't a terminal (the default) colors are left out, repeats are written as lines of their own
+     * and every line ends with a newline, so pipes and files get plain lines. Disable to always write for a terminal.
+     */
+    void enableTerminalDetection(const bool enable) { m_detectTerminal = enable; }
+    [[nodiscard]] bool isTerminalDetectionEnabled() const { return m_detectTerminal; }
+
+    /** Write every line right away (the default) or gather them, see ConsoleOutput */
+    void setFlushPolicy(const FlushPolicy &policy)
+    {
+        std::lock_guard lock(m_mutex);
+        m_output.setFlushPolicy(policy);
+    }
+    [[nodiscard]] FlushPolicy getFlushPolicy() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_output.getFlushPolicy();
+    }
+
+    /** Layout of each line, DEFAULT_CONSOLE_PATTERN by default, {color} and {repeat} are filled in by the logger */
+    void setPattern(const PatternLayout &pattern)
+    {
+        std::lock_guard lock(m_mutex);
+        m_pattern = pattern;
+    }
+    [[nodiscard]] PatternLayout getPattern() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_pattern;
+    }
+
 private:
-    std::string m_repeatedMessage;
-    /* To prevent accidental message repetition while different log levels */
-    LogLevel m_repeatedLevel = LogLevel::NONE;
+    PatternLayout m_pattern = compilePattern<DEFAULT_CONSOLE_PATTERN>();
+
+    /* Hash of the last record (see hashRecordContent), repeats are rewritten in place with \r */
+    uint64_t m_repeatedHash = 0;
 
     bool m_color = false;
     bool m_fullColor = true;
+    bool m_detectTerminal = true;
 
     uint32_t m_repeatCount = 0;
+
+    /* Several threads can log through the same console logger, the repeat state is shared between them */
+    mutable std::mutex m_mutex;
+    /* Builds every line in a reused string, so writing doesn't allocate */
+    ConsoleOutput m_output{metrics()};
 };
 
-class FileLogger final : public LoggerLoc
+/** Writes records to a file, subclasses can change the layout by overriding formatRecord and beginFile */
+class FileLogger : public LoggerLoc
 {
 public:
     FileLogger() = default;
@@ -120,9 +336,139 @@ public:
 
     void log(const std::string &message, LogLevel level) override;
     void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    void flush() override;
+    void poll() override;
+
+    /** Defaults to FlushMode::ALWAYS, flushInterval is checked on every record and whenever the backend polls */
+    void setFlushPolicy(const FlushPolicy &policy);
+    [[nodiscard]] FlushPolicy getFlushPolicy();
+
+    /** Defaults to never rotating, compression and removing old files happen on a background thread */
+    void setRotationPolicy(const RotationPolicy &policy) noexcept(false);
+    [[nodiscard]] RotationPolicy getRotationPolicy();
+
+    /**
+     * Write a sidecar index of where the records of each time range and level are, so slog-query can skip the rest
+     * The index follows the file through rotation (compressed rotated files lose theirs), an existing index is added
+     * to when the file is appended to.
+     */
+    void setIndexPolicy(const IndexPolicy &policy) noexcept(false);
+    [[nodiscard]] IndexPolicy getIndexPolicy();
+
+    /** Layout of each line, DEFAULT_FILE_PATTERN by default, loggers with their own formatRecord ignore it */
+    void setPattern(const PatternLayout &pattern);
+    [[nodiscard]] PatternLayout getPattern();
+
+protected:
+    /** For subclasses that need extra open flags (std::ios::binary), they open the file themselves */
+    explicit FileLogger(std::ios::openmode openMode);
+
+    /** Appends the record to out, the default lays it out with the pattern (see setPattern) */
+    virtual void formatRecord(std::string &out, const LogRecord &record);
+    /** Appends whatever has to come first in a newly opened (or rotated) file, nothing by default */
+    virtual void beginFile(std::string &out);
 
 private:
     std::ofstream m_file;
+    std::ios::openmode m_openMode{};
+
+    /* Guards everything below, the backend's poll() can run while another thread logs */
+    std::mutex m_mutex;
+    FlushPolicy m_flushPolicy;
+    PatternLayout m_pattern = compilePattern<DEFAULT_FILE_PATTERN>();
+    std::string m_buffer;
+    std::chrono::steady_clock::time_point m_bufferedSince;
+
+    std::filesystem::path m_filename;
+    std::size_t m_fileSize = 0;
+    RotationPolicy m_rotationPolicy;
+    std::chrono::system_clock::time_point m_nextRotation = std::chrono::system_clock::time_point::max();
+    std::shared_ptr<RotationWorker> m_rotationWorker;
+    /* Numbers the temporary names of rotated files */
+    uint64_t m_rotations = 0;
+    /* Size of the file when renaming it last failed, size based rotation waits for another maxBytes after it */
+    std::size_t m_failedRotationSize = 0;
+    /* The file couldn't be opened again after rotating, records are dropped until a retry opens it */
+    bool m_reopenPending = false;
+
+    IndexPolicy m_indexPolicy;
+    std::ofstream m_indexFile;
+    /* The entry being filled, and finished entries waiting for their records to be written */
+    LogIndexEntry m_indexEntry;
+    std::string m_indexBuffer;
+
+    /* Caller holds m_mutex */
+    void writeBuffer();
+    void rotate();
+    void scheduleNextRotation(std::chrono::system_clock::time_point now);
+    void openIndex() noexcept(false);
+    void closeIndex();
+    void finishIndexEntry();
+};
+
+#ifndef _WIN32
+
+constexpr std::size_t DEFAULT_MMAP_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+/**
+ * Writes records straight into a memory mapped, preallocated file segment, "<file>.0", "<file>.1", ...
+ * Nothing is copied through a stream buffer and no system call happens per record, the data sits in the page cache
+ * even if the process crashes. Segments are msync'd on flush() and on the sync interval, and truncated to the data
+ * written when they're closed (a segment left by a crash ends in zero bytes). Opening continues after the highest
+ * existing segment, segments with data in them are never overwritten.
+ */
+class MmapFileLogger final : public LoggerLoc
+{
+public:
+    MmapFileLogger() = default;
+    explicit MmapFileLogger(const std::string &filename, std::size_t segmentSize = DEFAULT_MMAP_SEGMENT_SIZE);
+    ~MmapFileLogger() override;
+
+    void openFile(const std::string &filename, std::size_t segmentSize = DEFAULT_MMAP_SEGMENT_SIZE) noexcept(false);
+    void closeFile();
+
+    void log(const std::string &message, LogLevel level) override;
+    void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    void flush() override;
+    void poll() override;
+
+    /** msync this often (checked on every record and whenever the backend polls), 0 only syncs on flush() */
+    void setSyncInterval(std::chrono::milliseconds interval);
+
+    /** Index of the segment currently written to */
+    [[nodiscard]] uint32_t getSegmentIndex();
+
+    /** Layout of each line, DEFAULT_FILE_PATTERN by default */
+    void setPattern(const PatternLayout &pattern);
+    [[nodiscard]] PatternLayout getPattern();
+
+private:
+    std::mutex m_mutex;
+    std::string m_filename;
+    std::size_t m_segmentSize = DEFAULT_MMAP_SEGMENT_SIZE;
+    uint32_t m_segmentIndex = 0;
+
+    int m_fd = -1;
+    char *m_mapping = nullptr;
+    std::size_t m_offset = 0;
+    std::size_t m_syncedOffset = 0;
+
+    std::chrono::milliseconds m_syncInterval = std::chrono::milliseconds(0);
+    std::chrono::steady_clock::time_point m_lastSync;
+
+    PatternLayout m_pattern = compilePattern<DEFAULT_FILE_PATTERN>();
+
+    /* Reused for formatting so writing a record doesn't allocate */
+    std::string m_line;
+
+    /* Caller holds m_mutex */
+    void openSegment();
+    void closeSegment();
+    void sync();
 };
 
+#endif // _WIN32
+
 } // namespace slog
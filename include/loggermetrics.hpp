@@ -0,0 +1,186 @@
+/**
+ * @brief Counters SimpleLogger keeps about itself and its loggers
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "logrecord.hpp"
+#include "ringqueue.hpp"
+
+namespace slog
+{
+
+class LoggerLoc;
+
+/* Counters are spread over this many cache line aligned shards, every thread adds to its own (round robin) */
+constexpr std::size_t METRICS_SHARDS = 16;
+/* One of this many records of a thread is timed in every logger, so the clock isn't read twice per logger */
+constexpr uint32_t SINK_TIMING_SAMPLE_INTERVAL = 16;
+
+/** Distribution of the time spent in a logger, from the sampled records */
+struct LatencySummary
+{
+    uint64_t samples = 0;
+    uint64_t totalNs = 0;
+    /* Upper bounds of the buckets the percentiles fall in, buckets are a quarter of a power of two wide */
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+/** Counters of one logger, see SinkMetrics */
+struct SinkMetricsSnapshot
+{
+    std::shared_ptr<LoggerLoc> logger;
+    /* Class name of the logger */
+    std::string name;
+
+    /* Records passed to the logger that are within / outside its levels */
+    uint64_t accepted = 0;
+    uint64_t filtered = 0;
+    /* Bytes the logger wrote and how often it pushed buffered data out (write or msync) */
+    uint64_t bytes = 0;
+    uint64_t flushes = 0;
+    /* Accepted records the logger lost instead of writing (a block that failed to compress) */
+    uint64_t dropped = 0;
+    LatencySummary latency;
+};
+
+/** Everything SimpleLogger::metrics() reports, counters only ever grow */
+struct MetricsSnapshot
+{
+    /* Records logged per level, indexed by static_cast<std::size_t>(LogLevel) */
+    std::array<uint64_t, 5> records{};
+    /* Calls to SimpleLogger::flush() */
+    uint64_t flushes = 0;
+
+    /* Asynchronous backend: records queued but not written yet, records whose thread had to wait for room in its
+     * buffer and records that were dropped or overwritten, see slog::BackpressurePolicy */
+    std::size_t queueDepth = 0;
+    uint64_t queueFullWaits = 0;
+    uint64_t dropped = 0;
+
+    std::vector<SinkMetricsSnapshot> sinks;
+};
+
+namespace detail
+{
+
+/* Sub buckets per power of two, durations up to 2^40 ns (about 18 minutes) get their own bucket */
+constexpr uint32_t LATENCY_SUB_BITS = 2;
+constexpr std::size_t LATENCY_BUCKETS = (40 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS;
+
+inline std::size_t latencyBucket(const uint64_t ns)
+{
+    constexpr uint64_t subBuckets = 1u << LATENCY_SUB_BITS;
+    if (ns < subBuckets)
+        return ns;
+
+    const auto shift = static_cast<std::size_t>(std::bit_width(ns)) - 1 - LATENCY_SUB_BITS;
+    const std::size_t bucket = ((shift + 1) << LATENCY_SUB_BITS) + ((ns >> shift) & (subBuckets - 1));
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/* Hands out shards round robin */
+uint32_t nextMetricsShard();
+
+} // namespace detail
+
+/** Shard the calling thread adds to, picked on its first use */
+inline uint32_t metricsShard()
+{
+    thread_local const uint32_t shard = detail::nextMetricsShard();
+    return shard;
+}
+
+/**
+ * Counters SimpleLogger and the logger itself keep about one LoggerLoc, see LoggerLoc::metrics
+ * Adding is a relaxed fetch_add on the calling thread's shard, reading sums every shard.
+ */
+class SinkMetrics
+{
+public:
+    void addAccepted() { shard().accepted.fetch_add(1, std::memory_order_relaxed); }
+    void addFiltered() { shard().filtered.fetch_add(1, std::memory_order_relaxed); }
+    void addBytes(const std::size_t bytes) { shard().bytes.fetch_add(bytes, std::memory_order_relaxed); }
+    void addFlush() { shard().flushes.fetch_add(1, std::memory_order_relaxed); }
+    void addDropped(const uint64_t records) { shard().dropped.fetch_add(records, std::memory_order_relaxed); }
+    void addLatency(const uint64_t ns)
+    {
+        Shard &current = shard();
+        current.latency[detail::latencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        current.latencyTotal.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    /** Sums the shards, logger and name are left for the caller */
+    [[nodiscard]] SinkMetricsSnapshot snapshot() const;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::atomic<uint64_t> accepted = 0;
+        std::atomic<uint64_t> filtered = 0;
+        std::atomic<uint64_t> bytes = 0;
+        std::atomic<uint64_t> flushes = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<uint64_t> latencyTotal = 0;
+        std::array<std::atomic<uint64_t>, detail::LATENCY_BUCKETS> latency{};
+    };
+
+    std::array<Shard, METRICS_SHARDS> m_shards{};
+
+    Shard &shard() { return m_shards[metricsShard()]; }
+};
+
+/** Counters of a SimpleLogger itself, sharded the same way as SinkMetrics */
+class LoggerMetrics
+{
+public:
+    void addRecord(const LogLevel level)
+    {
+        if (level >= LogLevel::DEBUG and level <= LogLevel::FATAL)
+            shard().records[static_cast<std::size_t>(level)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void addFlush() { shard().flushes.fetch_add(1, std::memory_order_relaxed); }
+    void addQueueFullWait() { shard().queueFullWaits.fetch_add(1, std::memory_order_relaxed); }
+    void addDropped() { shard().dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    /** Sums the shards into snapshot, the queue depth and the loggers are left for the caller */
+    void fill(MetricsSnapshot &snapshot) const;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::array<std::atomic<uint64_t>, 5> records{};
+        std::atomic<uint64_t> flushes = 0;
+        std::atomic<uint64_t> queueFullWaits = 0;
+        std::atomic<uint64_t> dropped = 0;
+    };
+
+    std::array<Shard, METRICS_SHARDS> m_shards{};
+
+    Shard &shard() { return m_shards[metricsShard()]; }
+};
+
+/** Class name of the logger ("FileLogger"), used to label its metrics */
+std::string loggerName(const LoggerLoc &loggerLoc);
+
+/**
+ * Writes the snapshot to the logger as INFO records with fields, one for SimpleLogger and one per logger
+ * "Logger metrics records_info=12 ... queue_depth=0" and "Sink metrics sink=FileLogger accepted=12 bytes=960 ..."
+ */
+void logMetrics(LoggerLoc &loggerLoc, const MetricsSnapshot &snapshot);
+
+} // namespace slog
@@ -0,0 +1,82 @@
+/**
+ * @brief Time and level index written next to log files, so large files can be searched without reading them whole
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "logrecord.hpp"
+
+namespace slog
+{
+
+/*
+ * Index layout ("<log file>.idx"), all integers in native byte order:
+ *   header  "SLOGIDX1" u32 0x01020304
+ *   entry   u64 offset, u64 length, i64 earliest and i64 latest unix time in ns, u32 records, u8 level mask (see
+ *           slog::levelBit), 3 bytes padding
+ * Each entry covers consecutive whole records of the log file. Entries are only written once the records they cover
+ * are, so a crash leaves the newest records unindexed rather than the index pointing past the end of the file.
+ */
+constexpr std::array<char, 8> LOG_INDEX_MAGIC = {'S', 'L', 'O', 'G', 'I', 'D', 'X', '1'};
+constexpr uint32_t LOG_INDEX_BYTE_ORDER = 0x01020304;
+constexpr std::size_t LOG_INDEX_HEADER_SIZE = LOG_INDEX_MAGIC.size() + sizeof(uint32_t);
+constexpr std::size_t LOG_INDEX_ENTRY_SIZE = 40;
+constexpr const char *LOG_INDEX_SUFFIX = ".idx";
+
+/** A run of records in a log file */
+struct LogIndexEntry
+{
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    int64_t earliestNs = 0;
+    int64_t latestNs = 0;
+    uint32_t records = 0;
+    uint8_t levels = 0;
+
+    /** Adds a record starting at offset (the first one sets the entry's offset) */
+    void add(uint64_t recordOffset, const LogRecord &record);
+};
+
+/** Byte range of a log file to read */
+struct LogIndexRange
+{
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+/** The index file of a log file */
+std::filesystem::path logIndexPath(const std::filesystem::path &logFile);
+/** Appends the index header / an entry in the layout above */
+void appendIndexHeader(std::string &out);
+void appendIndexEntry(std::string &out, const LogIndexEntry &entry);
+
+/** Reads the index of a log file, see FileLogger::setIndexPolicy */
+class LogIndexReader
+{
+public:
+    /** Throws slog::LogException if the index can't be read or isn't one, a cut off last entry is ignored */
+    explicit LogIndexReader(const std::filesystem::path &indexFile) noexcept(false);
+
+    [[nodiscard]] const std::vector<LogIndexEntry> &entries() const { return m_entries; }
+
+    /**
+     * Ranges of a log file of logSize bytes that can hold records in [fromNs, toNs) with a level in levels
+     * Whatever no entry covers (records from before the index was enabled or after the last entry written) is always
+     * included, adjacent ranges are merged.
+     */
+    [[nodiscard]] std::vector<LogIndexRange> find(int64_t fromNs, int64_t toNs, uint8_t levels,
+                                                  uint64_t logSize) const;
+
+private:
+    std::vector<LogIndexEntry> m_entries;
+};
+
+} // namespace slog
@@ -0,0 +1,385 @@
+/**
+ * @brief Configurable line layouts, parsed at compile time or at runtime
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "logrecord.hpp"
+
+namespace slog
+{
+
+/** Name of a level ("WARNING"), a table lookup */
+constexpr std::string_view levelName(const LogLevel level)
+{
+    constexpr std::array<std::string_view, 6> names = {"NONE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL"};
+    const auto index = static_cast<std::size_t>(static_cast<int>(level) + 1);
+    return index < names.size() ? names[index] : "UNKNOWN";
+}
+
+/** ANSI color the console loggers use for a level */
+constexpr std::string_view levelColor(const LogLevel level)
+{
+    constexpr std::array<std::string_view, 6> colors = {"\033[0m",  "\033[34m", "\033[32m",
+                                                        "\033[33m", "\033[31m", "\033[41m"};
+    const auto index = static_cast<std::size_t>(static_cast<int>(level) + 1);
+    return index < colors.size() ? colors[index] : colors[0];
+}
+
+constexpr std::string_view RESET_COLOR = "\033[0m";
+
+/* Longest strftime specification in a {time:...} token */
+constexpr std::size_t MAX_TIME_SPEC_LENGTH = 48;
+
+/**
+ * Tokens of a pattern, "{name}" or "{name:spec}", "{{" and "}}" are literal braces
+ *   {time}         the record's timestamp as "dd/mm/yyyy hh:mm:ss.fff", see slog::formatTime
+ *   {time:%H:%M}   strftime specification, %f is the fraction with the digits set by slog::setTimePrecision
+ *   {level}        level name, {msg} message, {fields} logfmt fields with a leading space (" key=value")
+ *   {category}     name of the slog::Category the record was logged in, empty for records without one
+ *   {thread}       " [id name]" for records that know their thread, {tid} and {thread_name} on their own
+ *   {file}         file name without directories, {path} with them, {line} and {func} of the call site
+ *   {color}        level color when the console logger colors only the level, {reset} ends it
+ *   {repeat}       " (Rep: N)" while the console logger rewrites a repeated line
+ * Every token other than time takes an alignment and a width like std::format does, "{level:>7}" or "{file:<12}".
+ */
+enum class PatternToken : uint8_t
+{
+    TEXT,
+    TIME,
+    LEVEL,
+    MESSAGE,
+    FIELDS,
+    CATEGORY,
+    THREAD,
+    THREAD_ID,
+    THREAD_NAME,
+    FILE,
+    PATH,
+    LINE,
+    FUNCTION,
+    COLOR,
+    RESET,
+    REPEAT
+};
+
+enum class PatternAlign : uint8_t
+{
+    LEFT,
+    RIGHT,
+    CENTER
+};
+
+/** One piece of a parsed pattern, text is the literal text or the time specification */
+struct PatternSegment
+{
+    PatternToken token = PatternToken::TEXT;
+    PatternAlign align = PatternAlign::LEFT;
+    uint16_t width = 0;
+    std::string_view text;
+};
+
+/** What the logger adds to the record, for the {color} and {repeat} tokens */
+struct PatternContext
+{
+    bool levelColor = false;
+    uint32_t repeats = 0;
+};
+
+namespace detail
+{
+
+/* Calls to it stop constant evaluation, so an invalid compile time pattern fails the build at this call */
+void invalidLogPattern(const char *error);
+
+constexpr bool parseNumber(const std::string_view text, uint16_t &value)
+{
+    if (text.empty() or text.size() > 4)
+        return false;
+
+    value = 0;
+    for (const char digit: text)
+    {
+        if (digit < '0' or digit > '9')
+            return false;
+        value = static_cast<uint16_t>(value * 10 + (digit - '0'));
+    }
+
+    return true;
+}
+
+constexpr const char *parseToken(const std::string_view name, const std::string_view spec, const bool hasSpec,
+                                 PatternSegment &segment)
+{
+    constexpr std::array<std::pair<std::string_view, PatternToken>, 15> tokens = {{
+            {"time", PatternToken::TIME},
+            {"level", PatternToken::LEVEL},
+            {"msg", PatternToken::MESSAGE},
+            {"fields", PatternToken::FIELDS},
+            {"category", PatternToken::CATEGORY},
+            {"thread", PatternToken::THREAD},
+            {"tid", PatternToken::THREAD_ID},
+            {"thread_name", PatternToken::THREAD_NAME},
+            {"file", PatternToken::FILE},
+            {"path", PatternToken::PATH},
+            {"line", PatternToken::LINE},
+            {"func", PatternToken::FUNCTION},
+            {"color", PatternToken::COLOR},
+            {"reset", PatternToken::RESET},
+            {"repeat", PatternToken::REPEAT},
+    }};
+
+    const auto found = std::ranges::find(tokens, name, &std::pair<std::string_view, PatternToken>::first);
+    if (found == tokens.end())
+        return "unknown token in log pattern";
+
+    segment = {found->second, PatternAlign::LEFT, 0, {}};
+    if (!hasSpec)
+        return nullptr;
+
+    if (segment.token == PatternToken::TIME)
+    {
+        if (spec.empty() or spec.size() > MAX_TIME_SPEC_LENGTH)
+            return "time specification in log pattern is empty or too long";
+
+        // Only one %f, the specification is split around it
+        const auto fraction = spec.find("%f");
+        if (fraction != std::string_view::npos and spec.find("%f", fraction + 2) != std::string_view::npos)
+            return "time specification in log pattern has more than one %f";
+
+        segment.text = spec;
+        return nullptr;
+    }
+
+    std::string_view width = spec;
+    if (!width.empty() and (width.front() == '<' or width.front() == '>' or width.front() == '^'))
+    {
+        segment.align = width.front() == '<'   ? PatternAlign::LEFT
+                        : width.front() == '>' ? PatternAlign::RIGHT
+                                               : PatternAlign::CENTER;
+        width.remove_prefix(1);
+    }
+
+    if (!parseNumber(width, segment.width))
+        return "width in log pattern isn't an alignment followed by a number";
+
+    return nullptr;
+}
+
+/** Parses pattern into segments (only counts them if segments is nullptr), returns an error or nullptr */
+constexpr const char *parsePattern(const std::string_view pattern, PatternSegment *segments, std::size_t &count)
+{
+    count = 0;
+    const auto add = [&](const PatternSegment &segment)
+    {
+        if (segments != nullptr)
+            segments[count] = segment;
+        count++;
+    };
+
+    std::size_t textStart = 0;
+    std::size_t i = 0;
+    while (i < pattern.size())
+    {
+        const char c = pattern[i];
+        if (c != '{' and c != '}')
+        {
+            i++;
+            continue;
+        }
+
+        // "{{" and "}}" end the text after their first brace and skip the second one
+        if (i + 1 < pattern.size() and pattern[i + 1] == c)
+        {
+            add({PatternToken::TEXT, PatternAlign::LEFT, 0, pattern.substr(textStart, i + 1 - textStart)});
+            i += 2;
+            textStart = i;
+            continue;
+        }
+
+        if (c == '}')
+            return "unmatched } in log pattern, use }} for a brace";
+
+        const auto close = pattern.find('}', i);
+        if (close == std::string_view::npos)
+            return "unterminated { in log pattern, use {{ for a brace";
+
+        if (i != textStart)
+            add({PatternToken::TEXT, PatternAlign::LEFT, 0, pattern.substr(textStart, i - textStart)});
+
+        const std::string_view token = pattern.substr(i + 1, close - i - 1);
+        const auto colon = token.find(':');
+        const bool hasSpec = colon != std::string_view::npos;
+
+        PatternSegment segment;
+        if (const char *error =
+                    parseToken(token.substr(0, colon), hasSpec ? token.substr(colon + 1) : std::string_view{}, hasSpec,
+                               segment))
+            return error;
+        add(segment);
+
+        i = close + 1;
+        textStart = i;
+    }
+
+    if (textStart != pattern.size())
+        add({PatternToken::TEXT, PatternAlign::LEFT, 0, pattern.substr(textStart)});
+
+    return nullptr;
+}
+
+template<std::size_t N>
+consteval std::array<PatternSegment, N> parsePatternSegments(const std::string_view pattern)
+{
+    std::array<PatternSegment, N> segments{};
+    std::size_t count = 0;
+    if (const char *error = parsePattern(pattern, segments.data(), count))
+        invalidLogPattern(error);
+
+    return segments;
+}
+
+consteval std::size_t countPatternSegments(const std::string_view pattern)
+{
+    std::size_t count = 0;
+    if (const char *error = parsePattern(pattern, nullptr, count))
+        invalidLogPattern(error);
+
+    return count;
+}
+
+/* Appends a token (not TEXT) without width */
+void appendToken(std::string &out, const PatternSegment &segment, const LogRecord &record,
+                 const PatternContext &context);
+
+/* Pads what was appended since start to width */
+void alignToken(std::string &out, std::size_t start, PatternAlign align, std::size_t width);
+
+inline void appendSegment(std::string &out, const PatternSegment &segment, const LogRecord &record,
+                          const PatternContext &context)
+{
+    if (segment.token == PatternToken::TEXT)
+    {
+        out += segment.text;
+        return;
+    }
+
+    const std::size_t start = out.size();
+    appendToken(out, segment, record, context);
+    if (segment.width != 0)
+        alignToken(out, start, segment.align, segment.width);
+}
+
+} // namespace detail
+
+/** A string literal usable as a template argument, see slog::compilePattern */
+template<std::size_t N>
+struct PatternString
+{
+    std::array<char, N> data{};
+
+    consteval PatternString(const char (&text)[N]) { std::copy_n(text, N, data.begin()); }
+
+    [[nodiscard]] constexpr std::string_view view() const { return {data.data(), N - 1}; }
+};
+
+/**
+ * A pattern parsed at compile time, format() appends each segment with the token known at compile time
+ * Literal text becomes a constant string appended in one go, and nothing is looked up while formatting.
+ */
+template<PatternString Pattern>
+struct CompiledPattern
+{
+    static constexpr std::size_t SIZE = detail::countPatternSegments(Pattern.view());
+    static constexpr std::array<PatternSegment, SIZE> SEGMENTS = detail::parsePatternSegments<SIZE>(Pattern.view());
+
+    static void format(std::string &out, const LogRecord &record, const PatternContext &context)
+    {
+        [&]<std::size_t... Index>(std::index_sequence<Index...>)
+        { (appendAt<Index>(out, record, context), ...); }(std::make_index_sequence<SIZE>{});
+    }
+
+private:
+    template<std::size_t Index>
+    static void appendAt(std::string &out, const LogRecord &record, const PatternContext &context)
+    {
+        constexpr PatternSegment segment = SEGMENTS[Index];
+
+        if constexpr (segment.token == PatternToken::TEXT)
+            out.append(segment.text.data(), segment.text.size());
+        else if constexpr (segment.token == PatternToken::MESSAGE and segment.width == 0)
+            out += record.message;
+        else
+            detail::appendSegment(out, segment, record, context);
+    }
+};
+
+/**
+ * Layout of a log line, either compiled (slog::compilePattern) or parsed when it's constructed
+ *
+ *     logger->setPattern(slog::compilePattern<"{time:%H:%M:%S.%f} {level:>7} {file}:{line} {msg}{fields}\n">());
+ *     logger->setPattern(slog::PatternLayout(patternFromConfig));
+ *
+ * Copies share the parsed pattern.
+ */
+class PatternLayout
+{
+public:
+    using FormatFunction = void (*)(std::string &out, const LogRecord &record, const PatternContext &context);
+
+    /** Parses pattern at runtime, throws slog::LogException if it's invalid */
+    explicit PatternLayout(std::string_view pattern) noexcept(false);
+    /** A compiled pattern, see slog::compilePattern */
+    PatternLayout(FormatFunction function, std::string_view pattern) : m_format(function), m_source(pattern) {}
+
+    /** Appends the record laid out by the pattern to out */
+    void format(std::string &out, const LogRecord &record, const PatternContext &context = {}) const
+    {
+        if (m_format != nullptr)
+        {
+            m_format(out, record, context);
+            return;
+        }
+
+        for (const auto &segment: m_segments)
+            detail::appendSegment(out, segment, record, context);
+    }
+
+    /** The pattern text */
+    [[nodiscard]] std::string_view source() const { return m_source; }
+    [[nodiscard]] bool isCompiled() const { return m_format != nullptr; }
+
+private:
+    FormatFunction m_format = nullptr;
+    std::string_view m_source;
+
+    /* Runtime patterns, the segments point into the shared text */
+    std::shared_ptr<const std::string> m_text;
+    std::vector<PatternSegment> m_segments;
+};
+
+/** A layout parsed at compile time, an invalid pattern fails the build */
+template<PatternString Pattern>
+PatternLayout compilePattern()
+{
+    return PatternLayout(&CompiledPattern<Pattern>::format, Pattern.view());
+}
+
+/* "[dd/mm/yyyy hh:mm:ss.mmm   LEVEL] [id name]: message key=value" */
+constexpr PatternString DEFAULT_FILE_PATTERN = "[{time} {level:>7}]{thread}: {msg}{fields}\n";
+/* The console loggers start every line with a line break (\r for rewritten repeats) and add the colors around it */
+constexpr PatternString DEFAULT_CONSOLE_PATTERN = "[{time} {color}{level:>7}{repeat}{reset}]{thread}: {msg}{fields}";
+
+} // namespace slog
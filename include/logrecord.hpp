@@ -0,0 +1,129 @@
+/**
+ * @brief Log record passed from SimpleLogger to every LoggerLoc
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <source_location>
+#include <string>
+#include <string_view>
+
+#include "timestamp.hpp"
+
+namespace slog
+{
+
+/* Enums for logger information */
+enum class LogLevel
+{
+    NONE = -1,
+    DEBUG = 0,
+    INFO,
+    WARNING,
+    ERROR,
+    FATAL
+};
+
+/** Bit for a level in a mask of enabled levels, NONE has no bit */
+constexpr uint8_t levelBit(const LogLevel level)
+{
+    return level < LogLevel::DEBUG ? 0 : static_cast<uint8_t>(1u << static_cast<int>(level));
+}
+
+/** Mask with every level from min to max (inclusive) set */
+constexpr uint8_t levelRangeMask(const LogLevel min, const LogLevel max)
+{
+    uint8_t mask = 0;
+    for (int level = static_cast<int>(min); level <= static_cast<int>(max); level++)
+        mask |= levelBit(static_cast<LogLevel>(level));
+
+    return mask;
+}
+
+/* Longer thread names are cut off, the same limit Linux has for its own thread names */
+constexpr std::size_t MAX_THREAD_NAME_LENGTH = 15;
+
+/** Name of the logging thread stored inline, so records don't allocate for it or point into thread local storage */
+struct ThreadName
+{
+    std::array<char, MAX_THREAD_NAME_LENGTH> data{};
+    uint8_t length = 0;
+
+    ThreadName() = default;
+    explicit ThreadName(const std::string_view name) :
+        length(static_cast<uint8_t>(std::min(name.size(), MAX_THREAD_NAME_LENGTH)))
+    {
+        std::copy_n(name.begin(), length, data.begin());
+    }
+
+    [[nodiscard]] std::string_view view() const { return {data.data(), length}; }
+    [[nodiscard]] bool empty() const { return length == 0; }
+};
+
+/* Records are reused with their buffers, buffers that grew beyond this for one large message are freed again */
+constexpr std::size_t MAX_RETAINED_RECORD_CAPACITY = 4096;
+
+/** A single message, the timestamp is taken when the message is logged rather than when it's written */
+struct LogRecord
+{
+    LogLevel level = LogLevel::NONE;
+    std::chrono::system_clock::time_point timestamp;
+    std::string message;
+
+    /* Deferred records carry a static format string and encoded arguments, the message is built when written */
+    std::string_view format;
+    std::string arguments;
+
+    /* Filled in once by SimpleLogger before the record reaches the loggers, empty for records built elsewhere */
+    FormattedTime time;
+
+    /* Thread that logged the record (the OS thread id where there is one), 0 for records built elsewhere */
+    uint32_t threadId = 0;
+    ThreadName threadName;
+
+    /* Typed key-value pairs from SL_LOG_*_KV, encoded by encodeFields (see structuredlog.hpp) */
+    std::string fields;
+
+    /* Where the record was logged, line 0 if unknown */
+    std::source_location location;
+
+    /* Name of the slog::Category it was logged in, empty for records without one (categories are never destroyed) */
+    std::string_view category;
+
+    /** Empty the record for reuse, keeping the buffers so filling it again doesn't allocate */
+    void reset()
+    {
+        for (std::string *buffer: {&message, &arguments, &fields})
+        {
+            if (buffer->capacity() > MAX_RETAINED_RECORD_CAPACITY)
+                std::string().swap(*buffer);
+            else
+                buffer->clear();
+        }
+
+        format = {};
+        time = {};
+        threadId = 0;
+        threadName = {};
+        location = {};
+        category = {};
+    }
+};
+
+/** A record for a message passed straight to a LoggerLoc's log(), timestamped now */
+inline LogRecord makeRecord(const LogLevel level, const std::string &message)
+{
+    LogRecord record;
+    record.level = level;
+    record.timestamp = std::chrono::system_clock::now();
+    record.message = message;
+    return record;
+}
+
+} // namespace slog
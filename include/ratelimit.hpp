@@ -0,0 +1,154 @@
+/**
+ * @brief Per call site rate limiting and sampling for the SL_LOG_*_LIMITED macros
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <source_location>
+#include <type_traits>
+
+#include "logrecord.hpp"
+
+namespace slog
+{
+
+/* A call site that suppressed messages logs how many at most this often */
+constexpr auto SUPPRESSED_SUMMARY_INTERVAL = std::chrono::seconds(1);
+
+/** How often a limited call site may log, see the SL_LOG_*_LIMITED macros */
+struct RateLimit
+{
+    enum class Kind : uint8_t
+    {
+        RATE,
+        SAMPLE
+    };
+
+    Kind kind = Kind::RATE;
+    /* RATE: nanoseconds per token and how far ahead of the clock the bucket may run (burst - 1 tokens) */
+    int64_t interval = 0;
+    int64_t tolerance = 0;
+    /* SAMPLE: calls that always log, then one of every `every` calls after them */
+    uint64_t first = 0;
+    uint64_t every = 1;
+
+    /** Token bucket, at most count (minimum 1) messages per second with bursts of up to burst (default count) */
+    static constexpr RateLimit perSecond(const uint32_t count, const uint32_t burst = 0)
+    {
+        const uint32_t rate = count == 0 ? 1 : count;
+
+        RateLimit limit;
+        limit.interval = 1'000'000'000 / static_cast<int64_t>(rate);
+        limit.tolerance = limit.interval * static_cast<int64_t>((burst == 0 ? rate : burst) - 1);
+        return limit;
+    }
+
+    /** Log the first of every `every` calls */
+    static constexpr RateLimit sample(const uint64_t every) { return firstThenSample(0, every); }
+
+    /** Log the first `first` calls, then one of every `every` calls after them */
+    static constexpr RateLimit firstThenSample(const uint64_t first, const uint64_t every)
+    {
+        RateLimit limit;
+        limit.kind = Kind::SAMPLE;
+        limit.first = first;
+        limit.every = every == 0 ? 1 : every;
+        return limit;
+    }
+};
+
+/**
+ * State of one limited call site, the macros keep one as a function local static so a site is keyed by its
+ * std::source_location without any lookup. Deciding whether a call logs is a single atomic operation (a fetch_add
+ * when sampling, a usually uncontended CAS for the token bucket) and happens before the message is built.
+ *
+ * Suppressed calls are counted, the next call that gets through (or the asynchronous backend, for sites that went
+ * quiet) logs "Suppressed messages from file:line" with the count as a field once every SUPPRESSED_SUMMARY_INTERVAL.
+ */
+class CallSiteLimiter
+{
+public:
+    CallSiteLimiter(const RateLimit &limit, LogLevel level, const std::source_location &location);
+
+    CallSiteLimiter(const CallSiteLimiter &) = delete;
+    CallSiteLimiter &operator=(const CallSiteLimiter &) = delete;
+
+    /** Whether this call may log, counts it as suppressed otherwise */
+    bool allow()
+    {
+        if (!(m_limit.kind == RateLimit::Kind::RATE ? takeToken() : sampled()))
+        {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (m_suppressed.load(std::memory_order_relaxed) != 0) [[unlikely]]
+            summarize(false);
+
+        return true;
+    }
+
+    /** Number of calls suppressed since the last summary */
+    [[nodiscard]] uint64_t suppressed() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+    /**
+     * Log the summary of every limited call site that suppressed messages, force ignores SUPPRESSED_SUMMARY_INTERVAL
+     * The backend of the global logger does this on its own, call it with force before exiting to not lose counts.
+     */
+    static void summarizeAll(bool force);
+
+private:
+    const RateLimit m_limit;
+    const LogLevel m_level;
+    const std::source_location m_location;
+
+    /* RATE: theoretical arrival time of the next token (GCRA), SAMPLE: number of calls */
+    std::atomic<int64_t> m_state = 0;
+    std::atomic<uint64_t> m_suppressed = 0;
+    std::atomic<int64_t> m_lastSummary = 0;
+
+    /* Every limiter ever constructed, they are function local statics that are never unlinked */
+    CallSiteLimiter *m_next = nullptr;
+    static std::atomic<CallSiteLimiter *> s_head;
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    bool takeToken()
+    {
+        const int64_t time = now();
+        int64_t arrival = m_state.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            const int64_t next = (arrival > time ? arrival : time) + m_limit.interval;
+            if (next - time > m_limit.tolerance + m_limit.interval)
+                return false;
+
+            if (m_state.compare_exchange_weak(arrival, next, std::memory_order_relaxed))
+                return true;
+        }
+    }
+
+    bool sampled()
+    {
+        const auto call = static_cast<uint64_t>(m_state.fetch_add(1, std::memory_order_relaxed));
+        return call < m_limit.first or (call - m_limit.first) % m_limit.every == 0;
+    }
+
+    void summarize(bool force);
+};
+
+/* The list of limiters is walked until exit, so a limiter must stay valid after its static storage is destroyed */
+static_assert(std::is_trivially_destructible_v<CallSiteLimiter>);
+
+} // namespace slog
@@ -0,0 +1,89 @@
+/**
+ * @brief Collapsing repeated records in front of any logger
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+/* Number of distinct recent records a RepeatFilter remembers */
+constexpr std::size_t DEFAULT_REPEAT_WINDOW = 8;
+/* A run of repeats is summarized at least this often, even if it hasn't ended */
+constexpr auto DEFAULT_REPEAT_TIMEOUT = std::chrono::seconds(5);
+
+/**
+ * Hash of what a record says: level, message (or format and arguments for deferred records) and fields
+ * Records with the same hash are treated as the same message, so nobody has to keep a copy of the text.
+ */
+uint64_t hashRecordContent(const LogRecord &record);
+/** hashRecordContent plus the call site, so the same text logged from different places is kept apart */
+uint64_t hashRecord(const LogRecord &record);
+
+/**
+ * Passes records on to another logger, dropping the ones that repeat one of the last few distinct records
+ * Repeats are only counted (by hash, nothing is copied). Once a run ends, its record was pushed out of the window by
+ * newer ones, timed out or the filter is flushed, the logger gets a single "Message from file:line repeated N more
+ * times" record instead.
+ *
+ *     logger->addLogger(std::make_shared<slog::RepeatFilter>(std::make_shared<slog::FileLogger>("app.log")));
+ *
+ * The filter starts with the levels of the logger it wraps, change them on the filter afterward.
+ */
+class RepeatFilter final : public LoggerLoc
+{
+public:
+    explicit RepeatFilter(std::shared_ptr<LoggerLoc> logger, std::size_t window = DEFAULT_REPEAT_WINDOW,
+                          std::chrono::milliseconds timeout = DEFAULT_REPEAT_TIMEOUT);
+
+    /** Plain messages have no record to hash, they go straight to the logger */
+    void log(const std::string &message, LogLevel level) override;
+    void exception(const LogException &exception) override;
+    void logRecord(const LogRecord &record) override;
+    /** Summarizes every run so far (their records stay in the window), then flushes the logger */
+    void flush() override;
+    void poll() override;
+    [[nodiscard]] bool needsFormattedMessage() const override { return m_logger->needsFormattedMessage(); }
+
+    [[nodiscard]] const std::shared_ptr<LoggerLoc> &getLogger() const { return m_logger; }
+
+private:
+    struct Entry
+    {
+        uint64_t hash = 0;
+        bool used = false;
+        uint32_t repeats = 0;
+
+        /* Taken from the latest repeat for the summary */
+        LogLevel level = LogLevel::NONE;
+        std::source_location location;
+        uint32_t threadId = 0;
+        ThreadName threadName;
+        std::chrono::system_clock::time_point firstRepeat;
+        std::chrono::system_clock::time_point lastSeen;
+    };
+
+    std::shared_ptr<LoggerLoc> m_logger;
+    std::chrono::milliseconds m_timeout;
+
+    /* Guards everything below, records from several threads reach the filter when logging synchronously */
+    std::mutex m_mutex;
+    std::vector<Entry> m_window;
+    /* Reused for every summary */
+    LogRecord m_summary;
+
+    void summarize(Entry &entry);
+    void summarizeExpired(std::chrono::system_clock::time_point now);
+};
+
+} // namespace slog
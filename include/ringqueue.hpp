@@ -0,0 +1,165 @@
+/**
+ * @brief Bounded lock-free ring queue used by the asynchronous backend
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace slog
+{
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded multi-producer queue (Vyukov's array based design)
+ * Each cell carries a sequence number, so a push is a single CAS on the enqueue position plus one release store and
+ * producers never wait on each other. Popping is safe from any thread as well, the backend is just the usual consumer.
+ */
+template<typename T>
+class RingQueue
+{
+public:
+    /** The capacity is rounded up to the next power of two (minimum 2) */
+    explicit RingQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_mask = size - 1;
+        m_cells = std::make_unique<Cell[]>(size);
+
+        for (std::size_t i = 0; i < size; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    RingQueue(const RingQueue &) = delete;
+    RingQueue &operator=(const RingQueue &) = delete;
+
+    /** Returns false without touching value if the queue is full */
+    bool tryPush(T &&value)
+    {
+        std::size_t position = 0;
+        T *slot = tryClaim(position);
+        if (slot == nullptr)
+            return false;
+
+        *slot = std::move(value);
+        publish(position);
+
+        return true;
+    }
+
+    /**
+     * Claims the next cell so the value can be written in place, nullptr if the queue is full
+     * The cell is invisible to consumers (and blocks the ones behind it) until publish(position) is called.
+     */
+    T *tryClaim(std::size_t &position)
+    {
+        Cell *cell;
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return nullptr; // Full
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        position = pos;
+        return &cell->value;
+    }
+
+    /** Hands a cell claimed with tryClaim to the consumers */
+    void publish(const std::size_t position)
+    {
+        m_cells[position & m_mask].sequence.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * Returns false if the queue is empty (or the oldest push is still in progress)
+     * The value is swapped out of the cell, so whatever value held before (like string capacity) is reused by a later
+     * tryClaim instead of being freed.
+     */
+    bool tryPop(T &value)
+    {
+        Cell *cell;
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // Empty
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        using std::swap;
+        swap(value, cell->value);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /** Number of pushes that have claimed a cell so far */
+    [[nodiscard]] std::size_t pushedCount() const { return m_enqueuePos.load(std::memory_order_acquire); }
+    /** Number of pops that have claimed a cell so far */
+    [[nodiscard]] std::size_t poppedCount() const { return m_dequeuePos.load(std::memory_order_acquire); }
+    /** Approximate number of queued elements */
+    [[nodiscard]] std::size_t size() const
+    {
+        const std::size_t pushed = pushedCount();
+        const std::size_t popped = poppedCount();
+        return pushed > popped ? pushed - popped : 0;
+    }
+    [[nodiscard]] std::size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask = 0;
+
+    /* Keep producers and the consumer off each other's cache line */
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_enqueuePos = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_dequeuePos = 0;
+};
+
+} // namespace slog
@@ -6,11 +6,24 @@
  */
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <memory>
+#include <mutex>
+#include <source_location>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "category.hpp"
+#include "deferredformat.hpp"
 #include "loggerloc.hpp"
+#include "ratelimit.hpp"
+#include "sinkregistry.hpp"
+#include "structuredlog.hpp"
 
 /** Logs the version information for SimpleLogger */
 #define SIMPLE_LOGGER_LOG_VERSION_INFO()                                                                               \
@@ -24,6 +37,37 @@ namespace slog
 
 constexpr auto SimpleLoggerVersion = "v0.0.4";
 
+/** Default number of records each logging thread can have queued before log() has to wait for the backend */
+constexpr std::size_t DEFAULT_ASYNC_QUEUE_CAPACITY = 1 << 12;
+
+/** What log() does when the calling thread's async buffer is full, see SimpleLogger::setBackpressure */
+enum class BackpressurePolicy : uint8_t
+{
+    /* Wait for the backend to make room, for at most BackpressureOptions::blockTimeout */
+    BLOCK,
+    /* Drop the record being logged */
+    DROP_NEWEST,
+    /* Drop the oldest record still queued by this thread to make room */
+    OVERWRITE_OLDEST,
+    /* Drop records below BackpressureOptions::dropBelow once only the reserved cells are left, the others wait */
+    DROP_BELOW_LEVEL,
+};
+
+/** How asynchronous logging behaves when the backend can't keep up */
+struct BackpressureOptions
+{
+    BackpressurePolicy policy = BackpressurePolicy::BLOCK;
+    /* BLOCK: how long log() waits before dropping the record, zero waits for good */
+    std::chrono::milliseconds blockTimeout{0};
+    /* DROP_BELOW_LEVEL: records of this level and up always get through */
+    LogLevel dropBelow = LogLevel::ERROR;
+    /* DROP_BELOW_LEVEL: cells of every thread buffer kept free for records of dropBelow and up */
+    std::size_t reservedCapacity = 64;
+};
+
+/* Per-thread staging queue of the asynchronous backend, see SimpleLogger::startAsync */
+struct ThreadBuffer;
+
 /**
  * Main class for accessing information of SimpleLogger
  * For the most part you can just use the Prepocessor macros instead though
@@ -31,26 +75,125 @@ constexpr auto SimpleLoggerVersion = "v0.0.4";
 class SimpleLogger
 {
 public:
-    SimpleLogger() = default;
+    SimpleLogger();
     ~SimpleLogger();
 
-    /** Access to the global logger (singleton) */
-    static std::shared_ptr<SimpleLogger> GlobalLogger();
+    /** Access to the global logger (singleton), safe to call from any thread and only an acquire load once created */
+    static SimpleLogger *GlobalLogger()
+    {
+        if (SimpleLogger *logger = s_GlobalLogger.load(std::memory_order_acquire); logger != nullptr) [[likely]]
+            return logger;
+
+        return InitGlobalLogger();
+    }
 
     /** Enable capturing all uncaught exceptions (via std::uncaught_exception()) */
     static void CaptureExceptions();
 
-    /** Log message with the provided level, options include slog::LogLevel::[DEBUG, INFO, WARNING, ERROR, FATAL] */
-    void log(const std::string &message, LogLevel level);
+    /**
+     * Log message with the provided level, options include slog::LogLevel::[DEBUG, INFO, WARNING, ERROR, FATAL]
+     * The message is copied into a reused record, so logging doesn't allocate once the record buffers have grown.
+     */
+    void log(std::string_view message, LogLevel level,
+             const std::source_location &location = std::source_location::current());
+    /** Log message in a category, whose level decides whether it's written instead of the global min/max levels */
+    void log(const Category &category, std::string_view message, LogLevel level,
+             const std::source_location &location = std::source_location::current());
+    /**
+     * Log a message that is only formatted when it's written, on the backend thread when logging asynchronously
+     * Arguments are copied into the record (strings by value), the format string must be a string literal.
+     */
+    template<typename... Args>
+    void logDeferred(const LogLevel level, const std::source_location &location,
+                     DeferredFormatString<const Args &...> format, const Args &...args)
+    {
+        static_assert(sizeof...(Args) <= MAX_DEFERRED_ARGUMENTS, "Too many arguments for a deferred message");
+
+        if (!isLevelEnabled(level))
+            return;
+
+        RecordWriter writer(*this, level, location);
+        writer.record().format = format.get();
+        encodeArguments(writer.record().arguments, args...);
+        writer.commit();
+    }
+    /** Deferred formatting version of log(category, message, level) */
+    template<typename... Args>
+    void logDeferred(const Category &category, const LogLevel level, const std::source_location &location,
+                     DeferredFormatString<const Args &...> format, const Args &...args)
+    {
+        static_assert(sizeof...(Args) <= MAX_DEFERRED_ARGUMENTS, "Too many arguments for a deferred message");
+
+        if (!category.isEnabled(level))
+            return;
+
+        RecordWriter writer(*this, level, location);
+        writer.record().format = format.get();
+        writer.record().category = category.name();
+        encodeArguments(writer.record().arguments, args...);
+        writer.commit();
+    }
+    /** Log a format string with already encoded arguments, see slog::encodeArguments */
+    void logEncoded(LogLevel level, std::string_view format, std::string &&arguments);
+    /**
+     * Log a message with typed key-value fields that structured loggers write as separate values
+     * logFields(level, location, "request done", "latency_us", 123, "status", 200), keys must be strings.
+     */
+    template<typename... Args>
+    void logFields(const LogLevel level, const std::source_location &location, const std::string_view message,
+                   const Args &...keyValues)
+    {
+        if (!isLevelEnabled(level))
+            return;
+
+        RecordWriter writer(*this, level, location);
+        writer.record().message = message;
+        encodeFields(writer.record().fields, keyValues...);
+        writer.commit();
+    }
+    /** Log a message with already encoded fields, see slog::encodeFields */
+    void logStructured(LogLevel level, std::string_view message, std::string &&fields);
     /** Log a slog::LogException, equivalent to log(exception.what(), slog::LogLevel::FATAL) for default loggers */
     void exception(const LogException &exception);
 
+    /**
+     * Switch to asynchronous logging, log() only queues the record and a backend thread writes it to the loggers
+     * Every logging thread gets its own queue of queueCapacity records on its first record, so producers never contend
+     * with each other. The backend merges what it drains from all of them by timestamp.
+     */
+    void startAsync(std::size_t queueCapacity = DEFAULT_ASYNC_QUEUE_CAPACITY);
+    /** Wait until every record logged before this call has been written, then flush all loggers */
+    void flush();
+    /** Drain the queue and stop the backend thread, logging is synchronous again afterward */
+    void shutdown();
+    /** Whether log() currently hands records to the backend thread */
+    [[nodiscard]] bool isAsync() const { return m_async.load(std::memory_order_relaxed); }
+
+    /**
+     * Choose what log() does when its thread's async buffer is full (waiting for good by default)
+     * Dropped records are counted in metrics() and the backend reports them to the loggers as a WARNING record with a
+     * "dropped" field. Synchronous logging never drops, it always writes the record before log() returns.
+     */
+    void setBackpressure(const BackpressureOptions &options);
+    [[nodiscard]] BackpressureOptions getBackpressure() const;
+
+    /** Name the calling thread in its records (cut off after MAX_THREAD_NAME_LENGTH characters), empty to clear it */
+    static void setThreadName(std::string_view name);
+    /** Name set for the calling thread with setThreadName */
+    [[nodiscard]] static std::string_view getThreadName();
+
     /** Set the maximum log level for the global logger, options include slog::LogLevel::[DEBUG, INFO, WARNING, ERROR,
      * FATAL] */
     void setMaxLogLevel(LogLevel level);
     /** Set the minimum log level for the global logger, see setMaxLogLevel */
     void setMinLogLevel(LogLevel level);
 
+    /** Whether any logger would write a message of this level, a single relaxed load so macros can check it first */
+    [[nodiscard]] bool isLevelEnabled(const LogLevel level) const
+    {
+        return (m_enabledLevels.load(std::memory_order_relaxed) & levelBit(level)) != 0;
+    }
+
     /** Access methods for MaxLogLevel */
     [[nodiscard]] LogLevel getMaxLogLevel() const { return m_maxLogLevel; }
     /** Access methods for MinLogLevel */
@@ -66,14 +209,117 @@ public:
     /** Access a logger by index, returns nullptr if the index is out of bounds */
     std::shared_ptr<LoggerLoc> getLogger(uint32_t index);
 
-private:
-    /* The first logger is always the console logger */
-    std::vector<std::shared_ptr<LoggerLoc>> m_loggerLocs;
+    /** Counters about this logger and each of its loggers so far, see slog::MetricsSnapshot */
+    [[nodiscard]] MetricsSnapshot metrics();
+    /**
+     * Write metrics() to loggerLoc every interval (as INFO records with fields, see slog::logMetrics), checked after
+     * each record and by the backend thread. loggerLoc doesn't need to be added to this logger, nullptr stops the dump.
+     */
+    void setMetricsDump(const std::shared_ptr<LoggerLoc> &loggerLoc, std::chrono::milliseconds interval);
 
-    LogLevel m_maxLogLevel = LogLevel::FATAL;
-    LogLevel m_minLogLevel = LogLevel::DEBUG;
+private:
+    /**
+     * Fills a record in place, commit() hands it to the loggers (synchronous) or the backend (asynchronous)
+     * The record is the thread's reused one or a cell of the thread's async buffer, so neither allocates once its
+     * buffers have grown, see LogRecord::reset.
+     */
+    class RecordWriter
+    {
+    public:
+        RecordWriter(SimpleLogger &logger, LogLevel level, const std::source_location &location);
+        ~RecordWriter();
+
+        RecordWriter(const RecordWriter &) = delete;
+        RecordWriter &operator=(const RecordWriter &) = delete;
+
+        [[nodiscard]] LogRecord &record() { return *m_record; }
+        void commit();
+
+    private:
+        SimpleLogger &m_logger;
+        LogRecord *m_record = nullptr;
+        bool m_committed = false;
+        /* The backpressure policy dropped the record, it's filled but never written */
+        bool m_dropped = false;
+
+        /* Claimed cell when logging asynchronously */
+        ThreadBuffer *m_buffer = nullptr;
+        std::size_t m_position = 0;
+
+        /* Synchronous, the thread's record or a new one when a logger logs from inside log() */
+        bool m_ownsThreadRecord = false;
+        std::unique_ptr<LogRecord> m_nested;
+    };
 
-    static std::shared_ptr<SimpleLogger> s_GlobalLogger;
+    /* The first logger is always the console logger */
+    SinkRegistry m_loggerLocs;
+
+    std::atomic<LogLevel> m_maxLogLevel = LogLevel::FATAL;
+    std::atomic<LogLevel> m_minLogLevel = LogLevel::DEBUG;
+
+    /* Union of every logger's levels limited to the global ones, recomputed whenever any of them changes */
+    std::atomic<uint8_t> m_enabledLevels = 0;
+    std::mutex m_enabledLevelsMutex;
+
+    /* Tells the thread local buffer caches of different SimpleLoggers apart, never reused */
+    const uint64_t m_id;
+    /* The global logger's levels are what slog::Category levels fall back to */
+    bool m_isGlobal = false;
+
+    /* Asynchronous backend, the thread buffers outlive it so late producers can still be drained */
+    std::mutex m_threadBuffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_threadBuffers;
+    std::size_t m_retiredPushed = 0;
+    std::atomic<std::size_t> m_threadBufferCapacity = DEFAULT_ASYNC_QUEUE_CAPACITY;
+    std::thread m_backend;
+    std::atomic<bool> m_async = false;
+
+    std::mutex m_drainMutex;
+    std::mutex m_backendMutex;
+    std::condition_variable m_backendWake;
+    std::condition_variable m_backendDrained;
+    bool m_stopBackend = false;
+    std::size_t m_flushTarget = 0;
+    std::size_t m_flushedUpTo = 0;
+    std::atomic<std::size_t> m_written = 0;
+    /* Records drained from every thread buffer (m_drainMutex), kept and swapped with the buffer cells so their
+     * string buffers circulate instead of being reallocated. m_order is the staged records sorted by timestamp. */
+    std::vector<LogRecord> m_staging;
+    std::vector<LogRecord *> m_order;
+    std::size_t m_drainStart = 0;
+
+    /* Read by producers only once their buffer is (almost) full, see claimRecord */
+    std::atomic<BackpressurePolicy> m_backpressurePolicy = BackpressurePolicy::BLOCK;
+    std::atomic<int64_t> m_blockTimeout = 0;
+    std::atomic<LogLevel> m_dropBelow = LogLevel::ERROR;
+    std::atomic<std::size_t> m_reservedCapacity = 64;
+    /* Records dropped since the backend last reported them */
+    std::atomic<uint64_t> m_unreportedDrops = 0;
+
+    LoggerMetrics m_metrics;
+    /* Periodic metrics dump, m_nextMetricsDump is in nanoseconds since the epoch and 0 while there is none */
+    std::atomic<int64_t> m_nextMetricsDump = 0;
+    std::mutex m_metricsDumpMutex;
+    std::shared_ptr<LoggerLoc> m_metricsDumpLogger;
+    std::chrono::milliseconds m_metricsDumpInterval{0};
+
+    void updateEnabledLevels();
+    ThreadBuffer &threadBuffer();
+    LogRecord *claimRecord(ThreadBuffer &buffer, LogLevel level, std::size_t &position);
+    void dropRecord();
+    void reportDrops();
+    std::size_t pushedCount();
+    void dispatch(LogRecord &record);
+    void dumpMetricsIfDue(std::chrono::system_clock::time_point now);
+    void flushLoggers();
+    void pollLoggers();
+    bool drainQueue();
+    void backendLoop();
+
+    static std::atomic<SimpleLogger *> s_GlobalLogger;
+    static SimpleLogger *InitGlobalLogger();
+
+    friend void notifyLevelsChanged();
 };
 
 } // namespace slog
@@ -82,6 +328,92 @@ private:
 #include <format>
 #endif // SL_ENABLE_STD_FORMAT
 
+/** Log message with the given level, the message is only evaluated if some logger would write it */
+#define SL_LOG_AT_LEVEL(level, message)                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+            sl_logger->log(message, level);                                                                            \
+    }                                                                                                                  \
+    while (false)
+
+/** Log formatted message with the given level, the arguments are captured and formatted later by the backend */
+#define SL_LOGD_AT_LEVEL(level, ...)                                                                                   \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+            sl_logger->logDeferred(level, std::source_location::current(), __VA_ARGS__);                               \
+    }                                                                                                                  \
+    while (false)
+
+/** Log message with key-value fields with the given level, nothing is encoded if no logger would write it */
+#define SL_LOGKV_AT_LEVEL(level, message, ...)                                                                         \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+            sl_logger->logFields(level, std::source_location::current(), message __VA_OPT__(, ) __VA_ARGS__);          \
+    }                                                                                                                  \
+    while (false)
+
+/** Log message in a slog::Category with the given level, the message is only evaluated if the category is enabled */
+#define SL_LOG_CAT_AT_LEVEL(category, level, message)                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (const slog::Category &sl_category = (category); sl_category.isEnabled(level))                              \
+            slog::SimpleLogger::GlobalLogger()->log(sl_category, message, level);                                      \
+    }                                                                                                                  \
+    while (false)
+
+/** Deferred formatting version of SL_LOG_CAT_AT_LEVEL, the arguments are only captured if the category is enabled */
+#define SL_LOGD_CAT_AT_LEVEL(category, level, ...)                                                                     \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (const slog::Category &sl_category = (category); sl_category.isEnabled(level))                              \
+            slog::SimpleLogger::GlobalLogger()->logDeferred(sl_category, level, std::source_location::current(),       \
+                                                            __VA_ARGS__);                                              \
+    }                                                                                                                  \
+    while (false)
+
+/**
+ * Log message with the given level unless the call site's slog::RateLimit suppresses it, see slog::CallSiteLimiter
+ * The limit is checked before the message is evaluated, suppressed calls are summarized by count.
+ */
+#define SL_LOG_LIMITED_AT_LEVEL(level, limit, message)                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+        {                                                                                                              \
+            static slog::CallSiteLimiter sl_limiter(limit, level, std::source_location::current());                    \
+            if (sl_limiter.allow())                                                                                    \
+                sl_logger->log(message, level);                                                                        \
+        }                                                                                                              \
+    }                                                                                                                  \
+    while (false)
+
+/** Deferred formatting version of SL_LOG_LIMITED_AT_LEVEL, the arguments are only captured if the call logs */
+#define SL_LOGD_LIMITED_AT_LEVEL(level, limit, ...)                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+        {                                                                                                              \
+            static slog::CallSiteLimiter sl_limiter(limit, level, std::source_location::current());                    \
+            if (sl_limiter.allow())                                                                                    \
+                sl_logger->logDeferred(level, std::source_location::current(), __VA_ARGS__);                           \
+        }                                                                                                              \
+    }                                                                                                                  \
+    while (false)
+
+#ifdef SL_ENABLE_STD_FORMAT
+/** Log formatted message with the given level, nothing is formatted if no logger would write it */
+#define SL_LOGF_AT_LEVEL(level, ...)                                                                                   \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (auto *sl_logger = slog::SimpleLogger::GlobalLogger(); sl_logger->isLevelEnabled(level))                    \
+            sl_logger->log(std::format(__VA_ARGS__), level);                                                           \
+    }                                                                                                                  \
+    while (false)
+#endif // SL_ENABLE_STD_FORMAT
+
 /** Gets the default console logger, this won't work if you've deleted it or cleared the loggers */
 #define SL_GET_CONSOLE_LOGGER()                                                                                        \
     std::dynamic_pointer_cast<slog::ConsoleLogger>(slog::SimpleLogger::GlobalLogger()->getLogger(0))
@@ -159,74 +491,170 @@ private:
 
 #ifdef SL_ENABLE_STD_FORMAT
 /** Log formatted message with the debug level */
-#define SL_LOGF_DEBUG(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::DEBUG)
+#define SL_LOGF_DEBUG(...) SL_LOGF_AT_LEVEL(slog::LogLevel::DEBUG, __VA_ARGS__)
 #endif // SL_ENABLE_STD_FORMAT
 
 /** Log message with the debug level */
-#define SL_LOG_DEBUG(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::DEBUG)
+#define SL_LOG_DEBUG(message) SL_LOG_AT_LEVEL(slog::LogLevel::DEBUG, message)
+/** Log formatted message with the debug level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_DEBUG(...) SL_LOGD_AT_LEVEL(slog::LogLevel::DEBUG, __VA_ARGS__)
+/** Log message with the debug level and key-value fields, SL_LOG_DEBUG_KV("done", "latency_us", 123) */
+#define SL_LOG_DEBUG_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::DEBUG, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the debug level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_DEBUG_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::DEBUG, limit, message)
+/** Log formatted message with the debug level, at most as often as limit allows */
+#define SL_LOGD_DEBUG_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::DEBUG, limit, __VA_ARGS__)
+/** Log message with the debug level in a slog::Category, SL_LOG_DEBUG_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_DEBUG_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::DEBUG, message)
+/** Log formatted message with the debug level in a slog::Category, formatted by the backend */
+#define SL_LOGD_DEBUG_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::DEBUG, __VA_ARGS__)
 
 #else
 #define SL_LOG_DEBUG(message)
+#define SL_LOGD_DEBUG(...)
+#define SL_LOG_DEBUG_KV(message, ...)
+#define SL_LOG_DEBUG_LIMITED(limit, message)
+#define SL_LOGD_DEBUG_LIMITED(limit, ...)
+#define SL_LOG_DEBUG_CAT(category, message)
+#define SL_LOGD_DEBUG_CAT(category, ...)
 #endif // NDEBUG
 
 #else // SL_MIN_LOG_LEVEL == 0
 #define SL_LOG_DEBUG(message)
+#define SL_LOGD_DEBUG(...)
+#define SL_LOG_DEBUG_KV(message, ...)
+#define SL_LOG_DEBUG_LIMITED(limit, message)
+#define SL_LOGD_DEBUG_LIMITED(limit, ...)
+#define SL_LOG_DEBUG_CAT(category, message)
+#define SL_LOGD_DEBUG_CAT(category, ...)
 #endif // SF_MIN_LOG_LEVEL == 0
 
 #if SL_MIN_LOG_LEVEL > 2
 
 #ifdef SL_ENABLE_STD_FORMAT
 /** Log formatted message with the info level */
-#define SF_LOGF_INFO(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::INFO)
+#define SL_LOGF_INFO(...) SL_LOGF_AT_LEVEL(slog::LogLevel::INFO, __VA_ARGS__)
 #endif // SL_ENABLE_STD_FORMAT
 
 /** Log message with the info level */
-#define SF_LOG_INFO(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::INFO)
+#define SL_LOG_INFO(message) SL_LOG_AT_LEVEL(slog::LogLevel::INFO, message)
+/** Log formatted message with the info level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_INFO(...) SL_LOGD_AT_LEVEL(slog::LogLevel::INFO, __VA_ARGS__)
+/** Log message with the info level and key-value fields, SL_LOG_INFO_KV("done", "latency_us", 123) */
+#define SL_LOG_INFO_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::INFO, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the info level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_INFO_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::INFO, limit, message)
+/** Log formatted message with the info level, at most as often as limit allows */
+#define SL_LOGD_INFO_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::INFO, limit, __VA_ARGS__)
+/** Log message with the info level in a slog::Category, SL_LOG_INFO_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_INFO_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::INFO, message)
+/** Log formatted message with the info level in a slog::Category, formatted by the backend */
+#define SL_LOGD_INFO_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::INFO, __VA_ARGS__)
 
 #else
-#define SF_LOG_INFO(message)
+#define SL_LOG_INFO(message)
+#define SL_LOGD_INFO(...)
+#define SL_LOG_INFO_KV(message, ...)
+#define SL_LOG_INFO_LIMITED(limit, message)
+#define SL_LOGD_INFO_LIMITED(limit, ...)
+#define SL_LOG_INFO_CAT(category, message)
+#define SL_LOGD_INFO_CAT(category, ...)
 #endif // SF_MIN_LOG_LEVEL > 0
 
 #if SL_MIN_LOG_LEVEL > 1
 
 #ifdef SL_ENABLE_STD_FORMAT
 /** Log formatted message with the warning level */
-#define Sl_LOGF_WARNING(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::WARNING)
+#define SL_LOGF_WARNING(...) SL_LOGF_AT_LEVEL(slog::LogLevel::WARNING, __VA_ARGS__)
 #endif // SL_ENABLE_STD_FORMAT
 
 /** Log message with the warning level */
-#define SL_LOG_WARNING(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::WARNING)
+#define SL_LOG_WARNING(message) SL_LOG_AT_LEVEL(slog::LogLevel::WARNING, message)
+/** Log formatted message with the warning level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_WARNING(...) SL_LOGD_AT_LEVEL(slog::LogLevel::WARNING, __VA_ARGS__)
+/** Log message with the warning level and key-value fields, SL_LOG_WARNING_KV("done", "latency_us", 123) */
+#define SL_LOG_WARNING_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::WARNING, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the warning level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_WARNING_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::WARNING, limit, message)
+/** Log formatted message with the warning level, at most as often as limit allows */
+#define SL_LOGD_WARNING_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::WARNING, limit, __VA_ARGS__)
+/** Log message with the warning level in a slog::Category, SL_LOG_WARNING_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_WARNING_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::WARNING, message)
+/** Log formatted message with the warning level in a slog::Category, formatted by the backend */
+#define SL_LOGD_WARNING_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::WARNING, __VA_ARGS__)
 
 #else
 #define SL_LOG_WARNING(message)
+#define SL_LOGD_WARNING(...)
+#define SL_LOG_WARNING_KV(message, ...)
+#define SL_LOG_WARNING_LIMITED(limit, message)
+#define SL_LOGD_WARNING_LIMITED(limit, ...)
+#define SL_LOG_WARNING_CAT(category, message)
+#define SL_LOGD_WARNING_CAT(category, ...)
 #endif // SF_MIN_LOG_LEVEL > 1
 
 #if SL_MIN_LOG_LEVEL > 0
 
 #ifdef SL_ENABLE_STD_FORMAT
 /** Log formatted message with the error level */
-#define Sl_LOGF_ERROR(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::ERROR)
+#define SL_LOGF_ERROR(...) SL_LOGF_AT_LEVEL(slog::LogLevel::ERROR, __VA_ARGS__)
 #endif // SL_ENABLE_STD_FORMAT
 
 /** Log message with the error level */
-#define Sl_LOG_ERROR(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::ERROR)
+#define SL_LOG_ERROR(message) SL_LOG_AT_LEVEL(slog::LogLevel::ERROR, message)
+/** Log formatted message with the error level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_ERROR(...) SL_LOGD_AT_LEVEL(slog::LogLevel::ERROR, __VA_ARGS__)
+/** Log message with the error level and key-value fields, SL_LOG_ERROR_KV("done", "latency_us", 123) */
+#define SL_LOG_ERROR_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::ERROR, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the error level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_ERROR_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::ERROR, limit, message)
+/** Log formatted message with the error level, at most as often as limit allows */
+#define SL_LOGD_ERROR_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::ERROR, limit, __VA_ARGS__)
+/** Log message with the error level in a slog::Category, SL_LOG_ERROR_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_ERROR_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::ERROR, message)
+/** Log formatted message with the error level in a slog::Category, formatted by the backend */
+#define SL_LOGD_ERROR_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::ERROR, __VA_ARGS__)
 
 #else
 #define SL_LOG_ERROR(message)
+#define SL_LOGD_ERROR(...)
+#define SL_LOG_ERROR_KV(message, ...)
+#define SL_LOG_ERROR_LIMITED(limit, message)
+#define SL_LOGD_ERROR_LIMITED(limit, ...)
+#define SL_LOG_ERROR_CAT(category, message)
+#define SL_LOGD_ERROR_CAT(category, ...)
 #endif // SF_MIN_LOG_LEVEL > 2
 
 #if SL_MIN_LOG_LEVEL > -1
 
 #ifdef SL_ENABLE_STD_FORMAT
 /** Log formatted message with the fatal level */
-#define Sl_LOGF_FATAL(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::FATAL)
+#define SL_LOGF_FATAL(...) SL_LOGF_AT_LEVEL(slog::LogLevel::FATAL, __VA_ARGS__)
 #endif // SL_ENABLE_STD_FORMAT
 
 /** Log message with the fatal level */
-#define Sl_LOG_FATAL(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::FATAL)
+#define SL_LOG_FATAL(message) SL_LOG_AT_LEVEL(slog::LogLevel::FATAL, message)
+/** Log formatted message with the fatal level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_FATAL(...) SL_LOGD_AT_LEVEL(slog::LogLevel::FATAL, __VA_ARGS__)
+/** Log message with the fatal level and key-value fields, SL_LOG_FATAL_KV("done", "latency_us", 123) */
+#define SL_LOG_FATAL_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::FATAL, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the fatal level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_FATAL_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::FATAL, limit, message)
+/** Log formatted message with the fatal level, at most as often as limit allows */
+#define SL_LOGD_FATAL_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::FATAL, limit, __VA_ARGS__)
+/** Log message with the fatal level in a slog::Category, SL_LOG_FATAL_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_FATAL_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::FATAL, message)
+/** Log formatted message with the fatal level in a slog::Category, formatted by the backend */
+#define SL_LOGD_FATAL_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::FATAL, __VA_ARGS__)
 
 #else
 #define SL_LOG_FATAL(message)
+#define SL_LOGD_FATAL(...)
+#define SL_LOG_FATAL_KV(message, ...)
+#define SL_LOG_FATAL_LIMITED(limit, message)
+#define SL_LOGD_FATAL_LIMITED(limit, ...)
+#define SL_LOG_FATAL_CAT(category, message)
+#define SL_LOGD_FATAL_CAT(category, ...)
 #endif // SL_MIN_LOG_LEVEL > 3
 
 #else // SL_MIN_LOG_LEVEL
@@ -234,28 +662,88 @@ private:
 #ifdef SL_ENABLE_STD_FORMAT
 
 /** Log formatted message with the debug level */
-#define SL_LOGF_DEBUG(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::DEBUG)
+#define SL_LOGF_DEBUG(...) SL_LOGF_AT_LEVEL(slog::LogLevel::DEBUG, __VA_ARGS__)
 /** Log formatted message with the info level */
-#define SL_LOGF_INFO(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::INFO)
+#define SL_LOGF_INFO(...) SL_LOGF_AT_LEVEL(slog::LogLevel::INFO, __VA_ARGS__)
 /** Log formatted message with the warning level */
-#define SL_LOGF_WARNING(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::WARNING)
+#define SL_LOGF_WARNING(...) SL_LOGF_AT_LEVEL(slog::LogLevel::WARNING, __VA_ARGS__)
 /** Log formatted message with the error level */
-#define SL_LOGF_ERROR(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::ERROR)
+#define SL_LOGF_ERROR(...) SL_LOGF_AT_LEVEL(slog::LogLevel::ERROR, __VA_ARGS__)
 /** Log formatted message with the fatal level */
-#define SL_LOGF_FATAL(...) slog::SimpleLogger::GlobalLogger()->log(std::format(__VA_ARGS__), slog::LogLevel::FATAL)
+#define SL_LOGF_FATAL(...) SL_LOGF_AT_LEVEL(slog::LogLevel::FATAL, __VA_ARGS__)
 
 #endif // SL_ENABLE_STD_FORMAT
 // Log level not set, so default to everything
 /** Log message with the debug level */
-#define SL_LOG_DEBUG(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::DEBUG)
+#define SL_LOG_DEBUG(message) SL_LOG_AT_LEVEL(slog::LogLevel::DEBUG, message)
+/** Log formatted message with the debug level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_DEBUG(...) SL_LOGD_AT_LEVEL(slog::LogLevel::DEBUG, __VA_ARGS__)
+/** Log message with the debug level and key-value fields, SL_LOG_DEBUG_KV("done", "latency_us", 123) */
+#define SL_LOG_DEBUG_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::DEBUG, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the debug level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_DEBUG_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::DEBUG, limit, message)
+/** Log formatted message with the debug level, at most as often as limit allows */
+#define SL_LOGD_DEBUG_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::DEBUG, limit, __VA_ARGS__)
+/** Log message with the debug level in a slog::Category, SL_LOG_DEBUG_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_DEBUG_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::DEBUG, message)
+/** Log formatted message with the debug level in a slog::Category, formatted by the backend */
+#define SL_LOGD_DEBUG_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::DEBUG, __VA_ARGS__)
 /** Log message with the info level */
-#define SL_LOG_INFO(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::INFO)
+#define SL_LOG_INFO(message) SL_LOG_AT_LEVEL(slog::LogLevel::INFO, message)
+/** Log formatted message with the info level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_INFO(...) SL_LOGD_AT_LEVEL(slog::LogLevel::INFO, __VA_ARGS__)
+/** Log message with the info level and key-value fields, SL_LOG_INFO_KV("done", "latency_us", 123) */
+#define SL_LOG_INFO_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::INFO, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the info level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_INFO_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::INFO, limit, message)
+/** Log formatted message with the info level, at most as often as limit allows */
+#define SL_LOGD_INFO_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::INFO, limit, __VA_ARGS__)
+/** Log message with the info level in a slog::Category, SL_LOG_INFO_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_INFO_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::INFO, message)
+/** Log formatted message with the info level in a slog::Category, formatted by the backend */
+#define SL_LOGD_INFO_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::INFO, __VA_ARGS__)
 /** Log message with the warning level */
-#define SL_LOG_WARNING(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::WARNING)
+#define SL_LOG_WARNING(message) SL_LOG_AT_LEVEL(slog::LogLevel::WARNING, message)
+/** Log formatted message with the warning level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_WARNING(...) SL_LOGD_AT_LEVEL(slog::LogLevel::WARNING, __VA_ARGS__)
+/** Log message with the warning level and key-value fields, SL_LOG_WARNING_KV("done", "latency_us", 123) */
+#define SL_LOG_WARNING_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::WARNING, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the warning level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_WARNING_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::WARNING, limit, message)
+/** Log formatted message with the warning level, at most as often as limit allows */
+#define SL_LOGD_WARNING_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::WARNING, limit, __VA_ARGS__)
+/** Log message with the warning level in a slog::Category, SL_LOG_WARNING_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_WARNING_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::WARNING, message)
+/** Log formatted message with the warning level in a slog::Category, formatted by the backend */
+#define SL_LOGD_WARNING_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::WARNING, __VA_ARGS__)
 /** Log message with the error level */
-#define SL_LOG_ERROR(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::ERROR)
+#define SL_LOG_ERROR(message) SL_LOG_AT_LEVEL(slog::LogLevel::ERROR, message)
+/** Log formatted message with the error level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_ERROR(...) SL_LOGD_AT_LEVEL(slog::LogLevel::ERROR, __VA_ARGS__)
+/** Log message with the error level and key-value fields, SL_LOG_ERROR_KV("done", "latency_us", 123) */
+#define SL_LOG_ERROR_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::ERROR, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the error level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_ERROR_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::ERROR, limit, message)
+/** Log formatted message with the error level, at most as often as limit allows */
+#define SL_LOGD_ERROR_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::ERROR, limit, __VA_ARGS__)
+/** Log message with the error level in a slog::Category, SL_LOG_ERROR_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_ERROR_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::ERROR, message)
+/** Log formatted message with the error level in a slog::Category, formatted by the backend */
+#define SL_LOGD_ERROR_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::ERROR, __VA_ARGS__)
 /** Log message with the fatal level */
-#define SL_LOG_FATAL(message) slog::SimpleLogger::GlobalLogger()->log(message, slog::LogLevel::FATAL)
+#define SL_LOG_FATAL(message) SL_LOG_AT_LEVEL(slog::LogLevel::FATAL, message)
+/** Log formatted message with the fatal level, the arguments are captured and formatted by the backend */
+#define SL_LOGD_FATAL(...) SL_LOGD_AT_LEVEL(slog::LogLevel::FATAL, __VA_ARGS__)
+/** Log message with the fatal level and key-value fields, SL_LOG_FATAL_KV("done", "latency_us", 123) */
+#define SL_LOG_FATAL_KV(message, ...) SL_LOGKV_AT_LEVEL(slog::LogLevel::FATAL, message __VA_OPT__(, ) __VA_ARGS__)
+/** Log message with the fatal level, at most as often as the slog::RateLimit allows */
+#define SL_LOG_FATAL_LIMITED(limit, message) SL_LOG_LIMITED_AT_LEVEL(slog::LogLevel::FATAL, limit, message)
+/** Log formatted message with the fatal level, at most as often as limit allows */
+#define SL_LOGD_FATAL_LIMITED(limit, ...) SL_LOGD_LIMITED_AT_LEVEL(slog::LogLevel::FATAL, limit, __VA_ARGS__)
+/** Log message with the fatal level in a slog::Category, SL_LOG_FATAL_CAT(SL_CATEGORY("net.http"), "...") */
+#define SL_LOG_FATAL_CAT(category, message) SL_LOG_CAT_AT_LEVEL(category, slog::LogLevel::FATAL, message)
+/** Log formatted message with the fatal level in a slog::Category, formatted by the backend */
+#define SL_LOGD_FATAL_CAT(category, ...) SL_LOGD_CAT_AT_LEVEL(category, slog::LogLevel::FATAL, __VA_ARGS__)
 
 
 #endif // SL_MIN_LOG_LEVEL
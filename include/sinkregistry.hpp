@@ -0,0 +1,74 @@
+/**
+ * @brief Copy-on-write list of loggers that can be read without locks
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+using LoggerList = std::vector<std::shared_ptr<LoggerLoc>>;
+
+/**
+ * Holds the loggers of a SimpleLogger as an immutable snapshot (RCU style)
+ * Readers pin the current snapshot by publishing the global epoch in a per-thread slot, so reading costs no lock and
+ * no reference counting and threads never write to a shared cache line. Writers copy the list, swap the pointer and
+ * wait until no reader can still see the old snapshot before freeing it.
+ */
+class SinkRegistry
+{
+public:
+    /** Keeps the snapshot alive while it exists, guards may be nested on the same thread */
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const SinkRegistry &registry);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+        [[nodiscard]] const LoggerList &loggers() const { return *m_snapshot; }
+
+    private:
+        const LoggerList *m_snapshot;
+    };
+
+    SinkRegistry();
+    ~SinkRegistry();
+
+    SinkRegistry(const SinkRegistry &) = delete;
+    SinkRegistry &operator=(const SinkRegistry &) = delete;
+
+    /** Pin the current snapshot for reading */
+    [[nodiscard]] ReadGuard read() const { return ReadGuard(*this); }
+
+    void add(const std::shared_ptr<LoggerLoc> &loggerLoc);
+    void remove(const std::shared_ptr<LoggerLoc> &loggerLoc);
+    void clear();
+
+    /** Copy of the logger at index, nullptr if the index is out of bounds */
+    [[nodiscard]] std::shared_ptr<LoggerLoc> get(uint32_t index) const;
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    std::atomic<const LoggerList *> m_snapshot;
+
+    /* Writers are serialized, old snapshots wait here until every reader is done with them */
+    std::mutex m_writeMutex;
+    std::vector<const LoggerList *> m_retired;
+
+    void publish(const LoggerList *snapshot);
+};
+
+} // namespace slog
@@ -0,0 +1,98 @@
+/**
+ * @brief Typed key-value fields on records and the JSON and logfmt loggers writing them
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "deferredformat.hpp"
+#include "loggerloc.hpp"
+
+namespace slog
+{
+
+namespace detail
+{
+
+inline void encodeFieldPairs(std::string &) {}
+
+template<typename Key, typename Value, typename... Rest>
+void encodeFieldPairs(std::string &out, const Key &key, const Value &value, const Rest &...rest)
+{
+    static_assert(std::convertible_to<const Key &, std::string_view>, "Field keys must be strings");
+
+    appendString(out, std::string_view(key));
+    encodeArgument(out, value);
+    encodeFieldPairs(out, rest...);
+}
+
+} // namespace detail
+
+/**
+ * Appends key, value pairs to out in the encodeArguments encoding, every key is a STRING argument
+ * followed by its value, so fields can be stored and compacted like deferred arguments.
+ */
+template<typename... Args>
+void encodeFields(std::string &out, const Args &...keyValues)
+{
+    static_assert(sizeof...(Args) % 2 == 0, "Fields are given as key, value pairs");
+    detail::encodeFieldPairs(out, keyValues...);
+}
+
+/** A decoded field value, string points into the encoded fields */
+struct FieldValue
+{
+    ArgType type = ArgType::STRING;
+    union
+    {
+        bool boolean;
+        char character;
+        int64_t integer;
+        uint64_t unsignedInteger;
+        double number;
+        uint64_t pointer;
+    };
+    std::string_view string;
+};
+
+/** Takes the next field off the front of fields, false once they're used up (or malformed) */
+bool nextField(std::string_view &fields, std::string_view &key, FieldValue &value);
+
+/** Appends the fields as " key=value" pairs, values are quoted where logfmt needs it */
+void formatLogfmtFields(std::string &out, std::string_view fields);
+/** Appends the fields as ,"key":value members of a JSON object, keys JsonFileLogger uses itself become "field.key" */
+void formatJsonFields(std::string &out, std::string_view fields);
+/** Appends value as a quoted and escaped JSON string */
+void appendJsonString(std::string &out, std::string_view value);
+
+/**
+ * One JSON object per line, the time is RFC 3339 in UTC whatever slog::setTimeZone says:
+ * {"time":"2024-06-15T12:00:00.000Z","level":"INFO","thread":1234,"thread_name":"worker","message":"...",<fields>}
+ */
+class JsonFileLogger final : public FileLogger
+{
+public:
+    JsonFileLogger() = default;
+    explicit JsonFileLogger(const std::string &filename, LogFileMode mode = LogFileMode::APPEND);
+
+protected:
+    void formatRecord(std::string &out, const LogRecord &record) override;
+};
+
+/** One logfmt line per record: time="..." level=INFO thread=1234 thread_name=worker msg="..." <fields> */
+class LogfmtFileLogger final : public FileLogger
+{
+public:
+    LogfmtFileLogger() = default;
+    explicit LogfmtFileLogger(const std::string &filename, LogFileMode mode = LogFileMode::APPEND);
+
+protected:
+    void formatRecord(std::string &out, const LogRecord &record) override;
+};
+
+} // namespace slog
@@ -0,0 +1,72 @@
+/**
+ * @brief Cached timestamp formatting for log records
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+namespace slog
+{
+
+enum class TimeZone
+{
+    LOCAL,
+    UTC
+};
+
+/* The value is the number of fractional digits written */
+enum class TimePrecision
+{
+    MILLISECONDS = 3,
+    MICROSECONDS = 6,
+    NANOSECONDS = 9
+};
+
+constexpr std::size_t MAX_TIMESTAMP_LENGTH = 32;
+
+/** A formatted timestamp stored inline, so records can carry it without allocating */
+struct FormattedTime
+{
+    std::array<char, MAX_TIMESTAMP_LENGTH> data{};
+    uint8_t length = 0;
+
+    [[nodiscard]] std::string_view view() const { return {data.data(), length}; }
+    [[nodiscard]] bool empty() const { return length == 0; }
+};
+
+/**
+ * Format a timestamp as "dd/mm/yyyy hh:mm:ss.fff"
+ * Each thread caches the calendar part for the current minute, so most calls only write the second and fraction
+ * digits and never call into localtime.
+ */
+FormattedTime formatTime(std::chrono::system_clock::time_point time);
+/** Format a timestamp as RFC 3339 in UTC, "yyyy-mm-ddThh:mm:ss.fffZ", for machine readable output like JSON */
+FormattedTime formatRfc3339Time(std::chrono::system_clock::time_point time);
+
+/** Whether timestamps use the local time zone (default) or UTC */
+void setTimeZone(TimeZone timeZone);
+TimeZone getTimeZone();
+
+/** Number of fractional second digits, defaults to milliseconds */
+void setTimePrecision(TimePrecision precision);
+TimePrecision getTimePrecision();
+
+/** Calendar time of seconds in the time zone set with setTimeZone */
+std::tm toCalendarTime(std::time_t seconds);
+/**
+ * Seconds of a calendar time in timeZone, the inverse of toCalendarTime
+ * Out of range fields are normalized, so a day or hour past the end rolls over into the next month or day.
+ */
+std::time_t fromCalendarTime(std::tm calendar, TimeZone timeZone);
+/** Changes whenever the time zone or precision does, for caches of formatted times */
+uint32_t getTimeSettingsGeneration();
+
+} // namespace slog
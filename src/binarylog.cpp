@@ -0,0 +1,393 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "binarylog.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+#include "deferredformat.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+using detail::appendRaw;
+
+template<typename T>
+bool takeRaw(std::string_view &in, T &value)
+{
+    if (in.size() < sizeof(T))
+        return false;
+
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+void appendVarint(std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+
+    out += static_cast<char>(value);
+}
+
+bool takeVarint(std::string_view &in, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 and !in.empty(); shift += 7)
+    {
+        const auto byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/* Re-encodes arguments from encodeArguments with varints, returns false if they're malformed */
+bool compactArguments(std::string &out, std::string_view in)
+{
+    while (!in.empty())
+    {
+        const auto type = static_cast<ArgType>(in.front());
+        in.remove_prefix(1);
+        out += static_cast<char>(type);
+
+        switch (type)
+        {
+            case ArgType::BOOL:
+            case ArgType::CHAR:
+            {
+                char value = 0;
+                if (!takeRaw(in, value))
+                    return false;
+                out += value;
+                break;
+            }
+            case ArgType::INT64:
+            {
+                int64_t value = 0;
+                if (!takeRaw(in, value))
+                    return false;
+                appendVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+                break;
+            }
+            case ArgType::UINT64:
+            case ArgType::POINTER:
+            {
+                uint64_t value = 0;
+                if (!takeRaw(in, value))
+                    return false;
+                appendVarint(out, value);
+                break;
+            }
+            case ArgType::DOUBLE:
+            {
+                double value = 0;
+                if (!takeRaw(in, value))
+                    return false;
+                appendRaw(out, value);
+                break;
+            }
+            case ArgType::STRING:
+            {
+                uint32_t length = 0;
+                if (!takeRaw(in, length) or in.size() < length)
+                    return false;
+                appendVarint(out, length);
+                out.append(in.substr(0, length));
+                in.remove_prefix(length);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/* The reverse of compactArguments, back to what formatDeferred expects */
+bool expandArguments(std::string &out, std::string_view in)
+{
+    while (!in.empty())
+    {
+        const auto type = static_cast<ArgType>(in.front());
+        in.remove_prefix(1);
+        out += static_cast<char>(type);
+
+        uint64_t value = 0;
+        switch (type)
+        {
+            case ArgType::BOOL:
+            case ArgType::CHAR:
+                if (in.empty())
+                    return false;
+                out += in.front();
+                in.remove_prefix(1);
+                break;
+            case ArgType::INT64:
+                if (!takeVarint(in, value))
+                    return false;
+                appendRaw(out, static_cast<int64_t>((value >> 1) ^ (0 - (value & 1))));
+                break;
+            case ArgType::UINT64:
+            case ArgType::POINTER:
+                if (!takeVarint(in, value))
+                    return false;
+                appendRaw(out, value);
+                break;
+            case ArgType::DOUBLE:
+            {
+                double number = 0;
+                if (!takeRaw(in, number))
+                    return false;
+                appendRaw(out, number);
+                break;
+            }
+            case ArgType::STRING:
+                if (!takeVarint(in, value) or in.size() < value)
+                    return false;
+                appendRaw(out, static_cast<uint32_t>(value));
+                out.append(in.substr(0, value));
+                in.remove_prefix(value);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+BinaryFileLogger::BinaryFileLogger() : FileLogger(std::ios::binary) {}
+
+BinaryFileLogger::BinaryFileLogger(const std::string &filename, const LogFileMode mode) : FileLogger(std::ios::binary)
+{
+    // Opened here rather than by FileLogger so beginFile reaches this class
+    openFile(filename, mode);
+}
+
+void BinaryFileLogger::beginFile(std::string &out)
+{
+    m_formatIds.clear();
+    m_nextFormatId = PLAIN_MESSAGE_FORMAT_ID + 1;
+
+    out.append(BINARY_LOG_MAGIC.data(), BINARY_LOG_MAGIC.size());
+    appendRaw(out, BINARY_LOG_BYTE_ORDER);
+}
+
+void BinaryFileLogger::formatRecord(std::string &out, const LogRecord &record)
+{
+    uint32_t formatId = PLAIN_MESSAGE_FORMAT_ID;
+    m_payload.clear();
+
+    if (!record.format.empty() and compactArguments(m_payload, record.arguments))
+    {
+        FormatEntry &entry = m_formatIds[record.format.data()];
+        if (entry.id == PLAIN_MESSAGE_FORMAT_ID or entry.format != record.format)
+        {
+            entry.id = m_nextFormatId++;
+            entry.format = record.format;
+
+            out += static_cast<char>(BinaryEntry::FORMAT);
+            appendRaw(out, entry.id);
+            appendVarint(out, entry.format.size());
+            out += entry.format;
+        }
+
+        formatId = entry.id;
+    }
+    else
+    {
+        m_payload.clear();
+        if (!record.message.empty() or record.format.empty())
+            m_payload = record.message;
+        else
+            formatDeferred(m_payload, record.format, record.arguments);
+    }
+
+    const int64_t nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch()).count();
+
+    out += static_cast<char>(BinaryEntry::RECORD);
+    out += static_cast<char>(record.level);
+    appendRaw(out, nanoseconds);
+    appendRaw(out, record.threadId);
+    out += static_cast<char>(record.threadName.length);
+    out += record.threadName.view();
+    appendRaw(out, formatId);
+    appendVarint(out, m_payload.size());
+    out += m_payload;
+
+    m_payload.clear();
+    if (!compactArguments(m_payload, record.fields))
+        m_payload.clear();
+
+    appendVarint(out, m_payload.size());
+    out += m_payload;
+}
+
+BinaryLogReader::BinaryLogReader(const std::string &filename) :
+    m_file(filename, std::ios::in | std::ios::binary), m_filename(filename)
+{
+    if (!m_file.is_open())
+        throw LogException("Could not open log file: " + filename);
+
+    std::error_code error;
+    m_fileSize = std::filesystem::file_size(m_filename, error);
+}
+
+bool BinaryLogReader::fitsInFile(const uint64_t length)
+{
+    const auto position = static_cast<uint64_t>(m_file.tellg());
+    if (position <= m_fileSize and length <= m_fileSize - position)
+        return true;
+
+    // The file may have grown since it was last checked
+    std::error_code error;
+    m_fileSize = std::filesystem::file_size(m_filename, error);
+    return !error and position <= m_fileSize and length <= m_fileSize - position;
+}
+
+void BinaryLogReader::readHeader()
+{
+    std::array<char, BINARY_LOG_MAGIC.size() - 1> magic{};
+    uint32_t byteOrder = 0;
+
+    m_file.read(magic.data(), magic.size());
+    m_file.read(reinterpret_cast<char *>(&byteOrder), sizeof(byteOrder));
+
+    if (!m_file or !std::equal(magic.begin(), magic.end(), BINARY_LOG_MAGIC.begin() + 1))
+        throw LogException("Not a SimpleLogger binary log");
+    if (byteOrder != BINARY_LOG_BYTE_ORDER)
+        throw LogException("Binary log was written on a machine with a different byte order");
+
+    m_formats.clear();
+}
+
+bool BinaryLogReader::next(LogRecord &record)
+{
+    const auto readVarint = [&](uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            const int byte = m_file.get();
+            if (byte == std::char_traits<char>::eof())
+                return false;
+
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    };
+
+    while (true)
+    {
+        const int kind = m_file.get();
+        if (kind == std::char_traits<char>::eof())
+            return false;
+
+        switch (static_cast<BinaryEntry>(kind))
+        {
+            case BinaryEntry::HEADER:
+                readHeader();
+                break;
+            case BinaryEntry::FORMAT:
+            {
+                uint32_t id = 0;
+                uint64_t length = 0;
+                // A length past the end of the file is a cut off (or corrupt) entry, nothing is allocated for it
+                if (!m_file.read(reinterpret_cast<char *>(&id), sizeof(id)) or !readVarint(length) or
+                    !fitsInFile(length))
+                    return false;
+
+                std::string format(length, '\0');
+                if (!m_file.read(format.data(), static_cast<std::streamsize>(length)))
+                    return false;
+
+                m_formats[id] = std::move(format);
+                break;
+            }
+            case BinaryEntry::RECORD:
+            {
+                int8_t level = 0;
+                int64_t nanoseconds = 0;
+                uint32_t threadId = 0;
+                uint8_t threadNameLength = 0;
+                std::array<char, MAX_THREAD_NAME_LENGTH> threadName{};
+                uint32_t formatId = 0;
+                uint64_t length = 0;
+
+                if (!m_file.read(reinterpret_cast<char *>(&level), sizeof(level)) or
+                    !m_file.read(reinterpret_cast<char *>(&nanoseconds), sizeof(nanoseconds)) or
+                    !m_file.read(reinterpret_cast<char *>(&threadId), sizeof(threadId)) or
+                    !m_file.read(reinterpret_cast<char *>(&threadNameLength), sizeof(threadNameLength)) or
+                    threadNameLength > threadName.size() or !m_file.read(threadName.data(), threadNameLength) or
+                    !m_file.read(reinterpret_cast<char *>(&formatId), sizeof(formatId)) or !readVarint(length) or
+                    !fitsInFile(length))
+                {
+                    return false;
+                }
+
+                m_payload.resize(length);
+                if (!m_file.read(m_payload.data(), static_cast<std::streamsize>(length)) or !readVarint(length) or
+                    !fitsInFile(length))
+                    return false;
+
+                m_fields.resize(length);
+                if (!m_file.read(m_fields.data(), static_cast<std::streamsize>(length)))
+                    return false;
+
+                record.level = static_cast<LogLevel>(level);
+                record.timestamp = std::chrono::system_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                std::chrono::nanoseconds(nanoseconds)));
+                record.time = {};
+                record.threadId = threadId;
+                record.threadName = ThreadName(std::string_view(threadName.data(), threadNameLength));
+                record.format = {};
+                record.arguments.clear();
+                record.message.clear();
+                record.fields.clear();
+
+                if (!expandArguments(record.fields, m_fields))
+                    throw LogException("Corrupt binary log fields");
+
+                if (formatId == PLAIN_MESSAGE_FORMAT_ID)
+                {
+                    record.message = m_payload;
+                    return true;
+                }
+
+                const auto format = m_formats.find(formatId);
+                m_arguments.clear();
+                if (format == m_formats.end() or !expandArguments(m_arguments, m_payload))
+                    throw LogException("Corrupt binary log record");
+
+                record.format = format->second;
+                record.arguments = m_arguments;
+                formatDeferred(record.message, record.format, record.arguments);
+                return true;
+            }
+            default:
+                throw LogException("Corrupt binary log entry");
+        }
+    }
+}
+
+} // namespace slog
@@ -0,0 +1,117 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "category.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "simplelogger.hpp"
+
+namespace slog
+{
+
+/** Every category by name, plus the global logger's levels the root category follows */
+struct CategoryRegistry
+{
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Category>, std::less<>> categories;
+    std::unique_ptr<Category> root{new Category("", nullptr)};
+
+    /* Last levels the global logger reported, nothing is enabled until it exists */
+    uint8_t loggerLevels = 0;
+    LogLevel minLevel = LogLevel::DEBUG;
+    LogLevel maxLevel = LogLevel::FATAL;
+
+    static CategoryRegistry &instance()
+    {
+        /* Never destroyed, records still queued during shutdown point at category names */
+        static auto *registry = new CategoryRegistry;
+        return *registry;
+    }
+
+    /* Caller holds mutex */
+    Category &lookup(const std::string_view name)
+    {
+        if (name.empty())
+            return *root;
+
+        if (const auto found = categories.find(name); found != categories.end())
+            return *found->second;
+
+        const auto dot = name.rfind('.');
+        Category &parent = dot == std::string_view::npos ? *root : lookup(name.substr(0, dot));
+
+        auto category = std::unique_ptr<Category>(new Category(std::string(name), &parent));
+        Category &created = *category;
+        parent.m_children.push_back(&created);
+        categories.emplace(std::string(name), std::move(category));
+
+        created.update();
+        return created;
+    }
+};
+
+Category::Category(std::string name, Category *parent) : m_name(std::move(name)), m_parent(parent) {}
+
+Category &Category::get(const std::string_view name)
+{
+    // Create the global logger first, its levels reach the categories once it exists
+    SimpleLogger::GlobalLogger();
+
+    auto &registry = CategoryRegistry::instance();
+    std::lock_guard lock(registry.mutex);
+    return registry.lookup(name);
+}
+
+Category &Category::root() { return get({}); }
+
+void Category::setLevel(const LogLevel level)
+{
+    std::lock_guard lock(CategoryRegistry::instance().mutex);
+
+    m_level = level;
+    update();
+}
+
+void Category::inheritLevel()
+{
+    std::lock_guard lock(CategoryRegistry::instance().mutex);
+
+    m_level.reset();
+    update();
+}
+
+bool Category::hasOwnLevel() const
+{
+    std::lock_guard lock(CategoryRegistry::instance().mutex);
+    return m_level.has_value();
+}
+
+void Category::updateGlobalLevels(const uint8_t loggerLevels, const LogLevel minLevel, const LogLevel maxLevel)
+{
+    auto &registry = CategoryRegistry::instance();
+    std::lock_guard lock(registry.mutex);
+
+    registry.loggerLevels = loggerLevels;
+    registry.minLevel = minLevel;
+    registry.maxLevel = maxLevel;
+
+    registry.root->update();
+}
+
+void Category::update()
+{
+    const auto &registry = CategoryRegistry::instance();
+
+    const LogLevel level = m_level.has_value() ? *m_level
+                           : m_parent != nullptr ? m_parent->getLevel()
+                                                 : registry.minLevel;
+
+    m_effectiveLevel.store(level, std::memory_order_relaxed);
+    m_enabledLevels.store(levelRangeMask(level, registry.maxLevel) & registry.loggerLevels, std::memory_order_relaxed);
+
+    for (Category *child: m_children)
+        child->update();
+}
+
+} // namespace slog
@@ -0,0 +1,414 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "compressedlog.hpp"
+
+#include <string_view>
+
+#ifdef SL_HAS_ZLIB
+#include <zlib.h>
+#endif // SL_HAS_ZLIB
+
+#ifdef SL_HAS_ZSTD
+#include <zstd.h>
+#endif // SL_HAS_ZSTD
+
+#ifdef SL_HAS_LZ4
+#include <lz4frame.h>
+#endif // SL_HAS_LZ4
+
+namespace slog
+{
+
+class BlockCompressor
+{
+public:
+    virtual ~BlockCompressor() = default;
+
+    /** Replaces out with the block as one complete frame, false if the codec failed */
+    virtual bool compress(std::string_view block, std::string &out) = 0;
+};
+
+namespace
+{
+
+#ifdef SL_HAS_ZLIB
+/* Every block is a gzip member of its own, a file of concatenated members is a valid gzip file */
+class GzipCompressor final : public BlockCompressor
+{
+public:
+    explicit GzipCompressor(const int level)
+    {
+        // 15 + 16 window bits writes the gzip header and trailer instead of the zlib ones
+        if (deflateInit2(&m_stream, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            throw LogException("Could not initialize zlib for a compressed log file");
+    }
+
+    ~GzipCompressor() override { deflateEnd(&m_stream); }
+
+    bool compress(const std::string_view block, std::string &out) override
+    {
+        if (deflateReset(&m_stream) != Z_OK)
+            return false;
+
+        out.resize(deflateBound(&m_stream, static_cast<uLong>(block.size())));
+
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(block.data()));
+        m_stream.avail_in = static_cast<uInt>(block.size());
+        m_stream.next_out = reinterpret_cast<Bytef *>(out.data());
+        m_stream.avail_out = static_cast<uInt>(out.size());
+
+        const bool finished = deflate(&m_stream, Z_FINISH) == Z_STREAM_END;
+        out.resize(m_stream.total_out);
+        return finished;
+    }
+
+private:
+    z_stream m_stream{};
+};
+#endif // SL_HAS_ZLIB
+
+#ifdef SL_HAS_ZSTD
+class ZstdCompressor final : public BlockCompressor
+{
+public:
+    /* A level of 0 is zstd's default level */
+    explicit ZstdCompressor(const int level) : m_context(ZSTD_createCCtx()), m_level(level)
+    {
+        if (m_context == nullptr)
+            throw LogException("Could not initialize zstd for a compressed log file");
+    }
+
+    ~ZstdCompressor() override { ZSTD_freeCCtx(m_context); }
+
+    bool compress(const std::string_view block, std::string &out) override
+    {
+        out.resize(ZSTD_compressBound(block.size()));
+
+        const std::size_t size =
+                ZSTD_compressCCtx(m_context, out.data(), out.size(), block.data(), block.size(), m_level);
+        if (ZSTD_isError(size))
+            return false;
+
+        out.resize(size);
+        return true;
+    }
+
+private:
+    ZSTD_CCtx *m_context;
+    int m_level;
+};
+#endif // SL_HAS_ZSTD
+
+#ifdef SL_HAS_LZ4
+class Lz4Compressor final : public BlockCompressor
+{
+public:
+    /* A level of 0 is LZ4's fast default */
+    explicit Lz4Compressor(const int level) : m_level(level) {}
+
+    bool compress(const std::string_view block, std::string &out) override
+    {
+        LZ4F_preferences_t preferences{};
+        preferences.compressionLevel = m_level;
+        preferences.frameInfo.contentSize = block.size();
+
+        out.resize(LZ4F_compressFrameBound(block.size(), &preferences));
+
+        const std::size_t size = LZ4F_compressFrame(out.data(), out.size(), block.data(), block.size(), &preferences);
+        if (LZ4F_isError(size))
+            return false;
+
+        out.resize(size);
+        return true;
+    }
+
+private:
+    int m_level;
+};
+#endif // SL_HAS_LZ4
+
+std::unique_ptr<BlockCompressor> createCompressor(const CompressionOptions &options)
+{
+    switch (options.codec)
+    {
+#ifdef SL_HAS_ZLIB
+        case CompressionCodec::GZIP:
+            return std::make_unique<GzipCompressor>(options.level);
+#endif // SL_HAS_ZLIB
+#ifdef SL_HAS_ZSTD
+        case CompressionCodec::ZSTD:
+            return std::make_unique<ZstdCompressor>(options.level);
+#endif // SL_HAS_ZSTD
+#ifdef SL_HAS_LZ4
+        case CompressionCodec::LZ4:
+            return std::make_unique<Lz4Compressor>(options.level);
+#endif // SL_HAS_LZ4
+        default:
+            throw LogException("SimpleLogger was built without the library for this compression codec");
+    }
+}
+
+} // namespace
+
+CompressedFileLogger::CompressedFileLogger() : m_thread(&CompressedFileLogger::run, this) {}
+
+CompressedFileLogger::CompressedFileLogger(const std::string &filename, const CompressionOptions &options,
+                                           const LogFileMode mode) : CompressedFileLogger()
+{
+    openFile(filename, options, mode);
+}
+
+CompressedFileLogger::~CompressedFileLogger()
+{
+    closeFile();
+
+    {
+        std::lock_guard lock(m_queueMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+bool CompressedFileLogger::codecAvailable(const CompressionCodec codec)
+{
+    switch (codec)
+    {
+#ifdef SL_HAS_ZLIB
+        case CompressionCodec::GZIP:
+            return true;
+#endif // SL_HAS_ZLIB
+#ifdef SL_HAS_ZSTD
+        case CompressionCodec::ZSTD:
+            return true;
+#endif // SL_HAS_ZSTD
+#ifdef SL_HAS_LZ4
+        case CompressionCodec::LZ4:
+            return true;
+#endif // SL_HAS_LZ4
+        default:
+            return false;
+    }
+}
+
+void CompressedFileLogger::openFile(const std::string &filename, const CompressionOptions &options,
+                                    const LogFileMode mode)
+{
+    std::unique_ptr<BlockCompressor> compressor = createCompressor(options);
+
+    std::lock_guard lock(m_mutex);
+
+    if (m_open)
+    {
+        finishBlock();
+        waitForBlocks();
+    }
+
+    /* Only whole compressed blocks are written, each as a single system call */
+    std::ofstream file;
+    file.rdbuf()->pubsetbuf(nullptr, 0);
+    file.open(filename,
+              std::ios::binary | std::ios::out | (mode == LogFileMode::OVERWRITE ? std::ios::trunc : std::ios::app));
+    if (!file.is_open())
+        throw LogException("Could not open log file: " + filename);
+
+    {
+        std::lock_guard queueLock(m_queueMutex);
+        m_file = std::move(file);
+        m_compressor = std::move(compressor);
+    }
+
+    m_options = options;
+    m_block.reserve(options.blockSize);
+    m_open = true;
+}
+
+void CompressedFileLogger::closeFile()
+{
+    std::lock_guard lock(m_mutex);
+
+    if (!m_open)
+        return;
+
+    finishBlock();
+    waitForBlocks();
+
+    std::lock_guard queueLock(m_queueMutex);
+    m_file.close();
+    m_compressor.reset();
+    m_open = false;
+}
+
+void CompressedFileLogger::log(const std::string &message, const LogLevel level)
+{
+    logRecord(makeRecord(level, message));
+}
+
+void CompressedFileLogger::exception(const LogException &exception)
+{
+    std::string error = "Uncaught Exception Occurred! ";
+    error += exception.what();
+
+    log(error, LogLevel::FATAL);
+}
+
+void CompressedFileLogger::logRecord(const LogRecord &record)
+{
+    if (record.level < m_minLogLevel or record.level > m_maxLogLevel)
+        return;
+
+    std::lock_guard lock(m_mutex);
+
+    if (!m_open)
+        return;
+
+    if (m_block.empty())
+        m_blockStarted = std::chrono::steady_clock::now();
+
+    m_pattern.format(m_block, record);
+    m_blockRecords++;
+
+    if (m_block.size() >= m_options.blockSize or record.level >= m_options.flushLevel or
+        (m_options.flushInterval.count() != 0 and
+         std::chrono::steady_clock::now() - m_blockStarted >= m_options.flushInterval))
+    {
+        finishBlock();
+    }
+}
+
+void CompressedFileLogger::flush()
+{
+    std::lock_guard lock(m_mutex);
+
+    finishBlock();
+    waitForBlocks();
+}
+
+void CompressedFileLogger::poll()
+{
+    std::lock_guard lock(m_mutex);
+
+    if (!m_block.empty() and m_options.flushInterval.count() != 0 and
+        std::chrono::steady_clock::now() - m_blockStarted >= m_options.flushInterval)
+    {
+        finishBlock();
+    }
+}
+
+void CompressedFileLogger::setPattern(const PatternLayout &pattern)
+{
+    std::lock_guard lock(m_mutex);
+    m_pattern = pattern;
+}
+
+PatternLayout CompressedFileLogger::getPattern()
+{
+    std::lock_guard lock(m_mutex);
+    return m_pattern;
+}
+
+CompressionStats CompressedFileLogger::getStats()
+{
+    std::lock_guard lock(m_queueMutex);
+    return m_stats;
+}
+
+void CompressedFileLogger::finishBlock()
+{
+    if (m_block.empty())
+        return;
+
+    std::unique_lock lock(m_queueMutex);
+
+    // Logging waits once the compression thread falls too far behind, instead of holding ever more blocks
+    m_idle.wait(lock, [this] { return m_pending.size() < MAX_PENDING_COMPRESSED_BLOCKS; });
+
+    m_pending.push_back({std::move(m_block), m_blockRecords});
+    m_block.clear();
+    m_blockRecords = 0;
+    if (!m_spare.empty())
+    {
+        m_block.swap(m_spare.back());
+        m_spare.pop_back();
+    }
+
+    m_wake.notify_one();
+}
+
+void CompressedFileLogger::waitForBlocks()
+{
+    std::unique_lock lock(m_queueMutex);
+    m_idle.wait(lock, [this] { return m_pending.empty() and !m_busy; });
+}
+
+void CompressedFileLogger::run()
+{
+    std::string compressed;
+    std::unique_lock lock(m_queueMutex);
+
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return m_stop or !m_pending.empty(); });
+        if (m_pending.empty())
+            break;
+
+        PendingBlock pending = std::move(m_pending.front());
+        std::string &block = pending.data;
+        m_pending.pop_front();
+        m_busy = true;
+        m_idle.notify_all();
+
+        /* The file and compressor are only replaced while nothing is pending or being written */
+        lock.unlock();
+
+        bool written = false;
+        if (m_compressor->compress(block, compressed))
+        {
+            m_file.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            m_file.flush();
+            written = static_cast<bool>(m_file);
+
+            if (written)
+            {
+                metrics().addBytes(compressed.size());
+                metrics().addFlush();
+            }
+            else
+            {
+                // Full disk or I/O error, clear the state so the next block gets its own attempt
+                m_file.clear();
+                metrics().addDropped(pending.records);
+                reportLoggerError("Could not write a compressed log block, " + std::to_string(pending.records) +
+                                  " records are lost");
+            }
+        }
+        else
+        {
+            // Nothing can be written without the codec, make the loss visible instead of skipping the block quietly
+            metrics().addDropped(pending.records);
+            reportLoggerError("Could not compress a log block, " + std::to_string(pending.records) +
+                              " records are lost");
+        }
+
+        lock.lock();
+
+        if (written)
+        {
+            m_stats.blocks++;
+            m_stats.inputBytes += block.size();
+            m_stats.outputBytes += compressed.size();
+        }
+        else
+        {
+            m_stats.failedBlocks++;
+            m_stats.droppedRecords += pending.records;
+        }
+
+        block.clear();
+        m_spare.push_back(std::move(block));
+        m_busy = false;
+        m_idle.notify_all();
+    }
+}
+
+} // namespace slog
@@ -0,0 +1,197 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "loggerloc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace slog
+{
+
+namespace
+{
+
+#ifdef _WIN32
+void writeLines(const ConsoleStream stream, const std::string *lines, const std::size_t count)
+{
+    std::FILE *file = stream == ConsoleStream::STDOUT ? stdout : stderr;
+    for (std::size_t i = 0; i < count; i++)
+        std::fwrite(lines[i].data(), 1, lines[i].size(), file);
+    std::fflush(file);
+}
+#else
+/* Retries interrupted and partial writes, whatever the stream doesn't take (closed pipe, full non-blocking pipe) is
+ * lost rather than blocking or failing the program */
+void writeLines(const ConsoleStream stream, const std::string *lines, const std::size_t count)
+{
+    const int fd = stream == ConsoleStream::STDOUT ? STDOUT_FILENO : STDERR_FILENO;
+    // Whatever the program buffered through stdio goes out first so it stays ordered with the log lines
+    std::fflush(stream == ConsoleStream::STDOUT ? stdout : stderr);
+
+    if (count == 1)
+    {
+        const char *data = lines[0].data();
+        std::size_t remaining = lines[0].size();
+        while (remaining != 0)
+        {
+            const ssize_t written = ::write(fd, data, remaining);
+            if (written < 0 and errno == EINTR)
+                continue;
+            if (written <= 0)
+                return;
+
+            data += written;
+            remaining -= static_cast<std::size_t>(written);
+        }
+        return;
+    }
+
+    std::array<iovec, MAX_CONSOLE_BATCH_LINES> vectors{};
+    std::size_t vectorCount = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (!lines[i].empty())
+            vectors[vectorCount++] = {const_cast<char *>(lines[i].data()), lines[i].size()};
+    }
+
+    iovec *next = vectors.data();
+    while (vectorCount != 0)
+    {
+        const ssize_t written = ::writev(fd, next, static_cast<int>(vectorCount));
+        if (written < 0 and errno == EINTR)
+            continue;
+        if (written <= 0)
+            return;
+
+        // Skip what the kernel took, a partially written line continues where it stopped
+        auto taken = static_cast<std::size_t>(written);
+        while (vectorCount != 0 and taken >= next->iov_len)
+        {
+            taken -= next->iov_len;
+            next++;
+            vectorCount--;
+        }
+        if (vectorCount != 0)
+        {
+            next->iov_base = static_cast<char *>(next->iov_base) + taken;
+            next->iov_len -= taken;
+        }
+    }
+}
+#endif // _WIN32
+
+} // namespace
+
+bool isConsoleTerminal(const ConsoleStream stream)
+{
+#ifdef _WIN32
+    static const bool stdoutTerminal = _isatty(_fileno(stdout)) != 0;
+    static const bool stderrTerminal = _isatty(_fileno(stderr)) != 0;
+#else
+    static const bool stdoutTerminal = isatty(STDOUT_FILENO) != 0;
+    static const bool stderrTerminal = isatty(STDERR_FILENO) != 0;
+#endif // _WIN32
+
+    return stream == ConsoleStream::STDOUT ? stdoutTerminal : stderrTerminal;
+}
+
+void reportLoggerError(const std::string_view message)
+{
+    std::string line = "SimpleLogger: ";
+    line += message;
+    line += '\n';
+    writeLines(ConsoleStream::STDERR, &line, 1);
+}
+
+ConsoleOutput::~ConsoleOutput() { flush(); }
+
+std::string &ConsoleOutput::nextLine()
+{
+    if (m_pending == m_lines.size())
+        m_lines.emplace_back();
+
+    std::string &line = m_lines[m_pending];
+    line.clear();
+    return line;
+}
+
+void ConsoleOutput::write(const ConsoleStream stream, const LogLevel level)
+{
+    const std::size_t length = m_lines[m_pending].size();
+
+    if (m_flushPolicy.mode == FlushMode::ALWAYS)
+    {
+        m_metrics.addBytes(length);
+        m_metrics.addFlush();
+        writeLines(stream, &m_lines[m_pending], 1);
+        return;
+    }
+
+    // Lines for the other stream, or ones that would overflow the buffer, go out before this one
+    if (m_pending != 0 and (stream != m_stream or m_pendingBytes + length > m_flushPolicy.bufferSize))
+        writePending();
+
+    if (m_pending == 0)
+    {
+        m_stream = stream;
+        m_bufferedSince = std::chrono::steady_clock::now();
+    }
+
+    m_pending++;
+    m_pendingBytes += length;
+
+    if (m_pending == MAX_CONSOLE_BATCH_LINES or level >= m_flushPolicy.flushLevel or
+        (m_flushPolicy.flushBytes != 0 and m_pendingBytes >= m_flushPolicy.flushBytes) or
+        (m_flushPolicy.flushInterval.count() != 0 and
+         std::chrono::steady_clock::now() - m_bufferedSince >= m_flushPolicy.flushInterval))
+    {
+        writePending();
+    }
+}
+
+void ConsoleOutput::flush()
+{
+    if (m_pending != 0)
+        writePending();
+}
+
+void ConsoleOutput::poll()
+{
+    if (m_pending != 0 and m_flushPolicy.flushInterval.count() != 0 and
+        std::chrono::steady_clock::now() - m_bufferedSince >= m_flushPolicy.flushInterval)
+    {
+        writePending();
+    }
+}
+
+void ConsoleOutput::setFlushPolicy(const FlushPolicy &policy)
+{
+    flush();
+    m_flushPolicy = policy;
+}
+
+void ConsoleOutput::writePending()
+{
+    m_metrics.addBytes(m_pendingBytes);
+    m_metrics.addFlush();
+    writeLines(m_stream, m_lines.data(), m_pending);
+
+    // The line being built (if any) comes after the pending ones, it moves to the front with the written strings
+    // (and their capacity) behind it
+    const std::size_t end = std::min(m_pending + 1, m_lines.size());
+    std::rotate(m_lines.begin(), m_lines.begin() + static_cast<std::ptrdiff_t>(m_pending),
+                m_lines.begin() + static_cast<std::ptrdiff_t>(end));
+
+    m_pending = 0;
+    m_pendingBytes = 0;
+}
+
+} // namespace slog
@@ -0,0 +1,510 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "deferredformat.hpp"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+
+namespace slog
+{
+
+namespace
+{
+
+struct Argument
+{
+    ArgType type = ArgType::INT64;
+    int64_t signedValue = 0;
+    uint64_t unsignedValue = 0;
+    double floatValue = 0;
+    std::string_view stringValue;
+};
+
+template<typename T>
+bool readRaw(std::string_view &arguments, T &value)
+{
+    if (arguments.size() < sizeof(T))
+        return false;
+
+    std::memcpy(&value, arguments.data(), sizeof(T));
+    arguments.remove_prefix(sizeof(T));
+    return true;
+}
+
+/* Decodes at most MAX_DEFERRED_ARGUMENTS arguments, returns how many were read */
+std::size_t decodeArguments(std::string_view arguments, std::array<Argument, MAX_DEFERRED_ARGUMENTS> &decoded)
+{
+    std::size_t count = 0;
+
+    while (!arguments.empty() and count < decoded.size())
+    {
+        Argument &argument = decoded[count];
+        argument.type = static_cast<ArgType>(arguments.front());
+        arguments.remove_prefix(1);
+
+        bool valid = true;
+        switch (argument.type)
+        {
+            case ArgType::BOOL:
+            case ArgType::CHAR:
+            {
+                char value = 0;
+                valid = readRaw(arguments, value);
+                argument.signedValue = value;
+                break;
+            }
+            case ArgType::INT64:
+                valid = readRaw(arguments, argument.signedValue);
+                break;
+            case ArgType::UINT64:
+            case ArgType::POINTER:
+                valid = readRaw(arguments, argument.unsignedValue);
+                break;
+            case ArgType::DOUBLE:
+                valid = readRaw(arguments, argument.floatValue);
+                break;
+            case ArgType::STRING:
+            {
+                uint32_t length = 0;
+                valid = readRaw(arguments, length) and arguments.size() >= length;
+                if (valid)
+                {
+                    argument.stringValue = arguments.substr(0, length);
+                    arguments.remove_prefix(length);
+                }
+                break;
+            }
+            default:
+                valid = false;
+                break;
+        }
+
+        if (!valid)
+            break;
+
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Appends spec with its nested "{}" and "{n}" fields replaced by the integer arguments they refer to
+ * std::format_string only lets integers through, anything else (from a corrupt record) becomes 0.
+ */
+void resolveNestedFields(std::string &out, std::string_view spec,
+                         const std::array<Argument, MAX_DEFERRED_ARGUMENTS> &decoded, const std::size_t count,
+                         std::size_t &nextIndex)
+{
+    for (std::size_t open = spec.find('{'); open != std::string_view::npos; open = spec.find('{'))
+    {
+        const std::size_t close = spec.find('}', open);
+        if (close == std::string_view::npos)
+            break;
+
+        const std::string_view id = spec.substr(open + 1, close - open - 1);
+        out.append(spec.substr(0, open));
+        spec.remove_prefix(close + 1);
+
+        std::size_t index = nextIndex++;
+        if (!id.empty())
+        {
+            index = 0;
+            std::from_chars(id.data(), id.data() + id.size(), index);
+        }
+
+        uint64_t value = 0;
+        if (index < count and decoded[index].type == ArgType::UINT64)
+            value = decoded[index].unsignedValue;
+        else if (index < count and decoded[index].type == ArgType::INT64 and decoded[index].signedValue > 0)
+            value = static_cast<uint64_t>(decoded[index].signedValue);
+
+        std::array<char, 24> digits{};
+        char *end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+        out.append(digits.data(), static_cast<std::size_t>(end - digits.data()));
+    }
+
+    out.append(spec);
+}
+
+#ifdef __cpp_lib_format
+
+template<typename T>
+void formatWithSpec(std::string &out, const std::string_view spec, T value)
+{
+    std::string format = "{:";
+    format += spec;
+    format += '}';
+
+    // The call site was checked, a spec std::format still rejects can only come from a corrupt record
+    try
+    {
+        std::vformat_to(std::back_inserter(out), format, std::make_format_args(value));
+    }
+    catch (const std::format_error &)
+    {
+        out += format;
+    }
+}
+
+void formatArgument(std::string &out, const Argument &argument, const std::string_view spec)
+{
+    switch (argument.type)
+    {
+        case ArgType::BOOL:
+            formatWithSpec(out, spec, argument.signedValue != 0);
+            break;
+        case ArgType::CHAR:
+            formatWithSpec(out, spec, static_cast<char>(argument.signedValue));
+            break;
+        case ArgType::INT64:
+            formatWithSpec(out, spec, argument.signedValue);
+            break;
+        case ArgType::UINT64:
+            formatWithSpec(out, spec, argument.unsignedValue);
+            break;
+        case ArgType::DOUBLE:
+            formatWithSpec(out, spec, argument.floatValue);
+            break;
+        case ArgType::STRING:
+            formatWithSpec(out, spec, argument.stringValue);
+            break;
+        case ArgType::POINTER:
+            formatWithSpec(out, spec, reinterpret_cast<const void *>(argument.unsignedValue));
+            break;
+    }
+}
+
+#else // __cpp_lib_format
+
+/* [[fill]align][sign][#][0][width][.precision][L][type] */
+struct FormatSpec
+{
+    char fill = ' ';
+    char align = '\0';
+    char sign = '-';
+    bool alternate = false;
+    bool zeroPad = false;
+    std::size_t width = 0;
+    int precision = -1;
+    char type = '\0';
+};
+
+FormatSpec parseSpec(std::string_view spec)
+{
+    FormatSpec parsed;
+
+    const auto isAlign = [](const char c) { return c == '<' or c == '>' or c == '^'; };
+    if (spec.size() >= 2 and isAlign(spec[1]))
+    {
+        parsed.fill = spec[0];
+        parsed.align = spec[1];
+        spec.remove_prefix(2);
+    }
+    else if (!spec.empty() and isAlign(spec[0]))
+    {
+        parsed.align = spec[0];
+        spec.remove_prefix(1);
+    }
+
+    if (!spec.empty() and (spec[0] == '+' or spec[0] == '-' or spec[0] == ' '))
+    {
+        parsed.sign = spec[0];
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() and spec[0] == '#')
+    {
+        parsed.alternate = true;
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() and spec[0] == '0')
+    {
+        parsed.zeroPad = true;
+        spec.remove_prefix(1);
+    }
+    while (!spec.empty() and spec[0] >= '0' and spec[0] <= '9')
+    {
+        parsed.width = parsed.width * 10 + static_cast<std::size_t>(spec[0] - '0');
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() and spec[0] == '.')
+    {
+        spec.remove_prefix(1);
+        parsed.precision = 0;
+        while (!spec.empty() and spec[0] >= '0' and spec[0] <= '9')
+        {
+            parsed.precision = parsed.precision * 10 + (spec[0] - '0');
+            spec.remove_prefix(1);
+        }
+    }
+    if (!spec.empty() and spec[0] == 'L')
+        spec.remove_prefix(1);
+    if (!spec.empty())
+        parsed.type = spec[0];
+
+    return parsed;
+}
+
+/* Writes prefix (sign, 0x...) and body padded to the spec's width */
+void pad(std::string &out, const FormatSpec &spec, const std::string_view prefix, const std::string_view body,
+         const char defaultAlign)
+{
+    const std::size_t length = prefix.size() + body.size();
+    const std::size_t padding = spec.width > length ? spec.width - length : 0;
+
+    if (spec.zeroPad and spec.align == '\0')
+    {
+        out.append(prefix);
+        out.append(padding, '0');
+        out.append(body);
+        return;
+    }
+
+    const char align = spec.align == '\0' ? defaultAlign : spec.align;
+    const std::size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+
+    out.append(before, spec.fill);
+    out.append(prefix);
+    out.append(body);
+    out.append(padding - before, spec.fill);
+}
+
+void formatInteger(std::string &out, const FormatSpec &spec, const bool negative, const uint64_t magnitude)
+{
+    if (spec.type == 'c')
+    {
+        const char c = static_cast<char>(magnitude);
+        pad(out, spec, {}, std::string_view(&c, 1), '<');
+        return;
+    }
+
+    int base = 10;
+    std::string_view alternatePrefix;
+    switch (spec.type)
+    {
+        case 'x':
+        case 'X':
+            base = 16;
+            alternatePrefix = spec.type == 'x' ? "0x" : "0X";
+            break;
+        case 'b':
+        case 'B':
+            base = 2;
+            alternatePrefix = spec.type == 'b' ? "0b" : "0B";
+            break;
+        case 'o':
+            base = 8;
+            alternatePrefix = magnitude == 0 ? "" : "0";
+            break;
+        default:
+            break;
+    }
+
+    std::array<char, 72> digits{};
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), magnitude, base);
+    if (spec.type == 'X')
+    {
+        for (char *c = digits.data(); c != result.ptr; c++)
+        {
+            if (*c >= 'a' and *c <= 'f')
+                *c = static_cast<char>(*c - 'a' + 'A');
+        }
+    }
+
+    std::string prefix;
+    if (negative)
+        prefix += '-';
+    else if (spec.sign == '+' or spec.sign == ' ')
+        prefix += spec.sign;
+    if (spec.alternate)
+        prefix += alternatePrefix;
+
+    pad(out, spec, prefix, std::string_view(digits.data(), result.ptr - digits.data()), '>');
+}
+
+void formatFloat(std::string &out, const FormatSpec &spec, const double value)
+{
+    std::array<char, 512> digits{};
+    std::to_chars_result result{};
+    char *begin = digits.data();
+    char *end = digits.data() + digits.size();
+
+    const double magnitude = std::fabs(value);
+    switch (spec.type)
+    {
+        case 'f':
+        case 'F':
+            result = std::to_chars(begin, end, magnitude, std::chars_format::fixed,
+                                   spec.precision < 0 ? 6 : spec.precision);
+            break;
+        case 'e':
+        case 'E':
+            result = std::to_chars(begin, end, magnitude, std::chars_format::scientific,
+                                   spec.precision < 0 ? 6 : spec.precision);
+            break;
+        case 'a':
+        case 'A':
+            result = spec.precision < 0 ? std::to_chars(begin, end, magnitude, std::chars_format::hex)
+                                        : std::to_chars(begin, end, magnitude, std::chars_format::hex, spec.precision);
+            break;
+        case 'g':
+        case 'G':
+            result = std::to_chars(begin, end, magnitude, std::chars_format::general,
+                                   spec.precision < 0 ? 6 : spec.precision);
+            break;
+        default:
+            result = spec.precision < 0 ? std::to_chars(begin, end, magnitude)
+                                        : std::to_chars(begin, end, magnitude, std::chars_format::general,
+                                                        spec.precision);
+            break;
+    }
+
+    if (spec.type == 'F' or spec.type == 'E' or spec.type == 'A' or spec.type == 'G')
+    {
+        for (char *c = begin; c != result.ptr; c++)
+        {
+            if (*c >= 'a' and *c <= 'z')
+                *c = static_cast<char>(*c - 'a' + 'A');
+        }
+    }
+
+    std::string_view prefix;
+    if (std::signbit(value))
+        prefix = "-";
+    else if (spec.sign == '+')
+        prefix = "+";
+    else if (spec.sign == ' ')
+        prefix = " ";
+
+    pad(out, spec, prefix, std::string_view(begin, result.ptr - begin), '>');
+}
+
+void formatArgument(std::string &out, const Argument &argument, const std::string_view specText)
+{
+    const FormatSpec spec = parseSpec(specText);
+    const bool asInteger = spec.type != '\0' and spec.type != 's' and spec.type != 'c' and spec.type != '?';
+
+    switch (argument.type)
+    {
+        case ArgType::BOOL:
+            if (asInteger)
+                formatInteger(out, spec, false, static_cast<uint64_t>(argument.signedValue));
+            else
+                pad(out, spec, {}, argument.signedValue != 0 ? "true" : "false", '<');
+            break;
+        case ArgType::CHAR:
+            if (asInteger)
+            {
+                formatInteger(out, spec, argument.signedValue < 0,
+                              argument.signedValue < 0 ? static_cast<uint64_t>(-argument.signedValue)
+                                                       : static_cast<uint64_t>(argument.signedValue));
+            }
+            else
+            {
+                const char c = static_cast<char>(argument.signedValue);
+                pad(out, spec, {}, std::string_view(&c, 1), '<');
+            }
+            break;
+        case ArgType::INT64:
+        {
+            const bool negative = argument.signedValue < 0;
+            const uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(argument.signedValue)
+                                                : static_cast<uint64_t>(argument.signedValue);
+            formatInteger(out, spec, negative, magnitude);
+            break;
+        }
+        case ArgType::UINT64:
+            formatInteger(out, spec, false, argument.unsignedValue);
+            break;
+        case ArgType::DOUBLE:
+            formatFloat(out, spec, argument.floatValue);
+            break;
+        case ArgType::STRING:
+        {
+            std::string_view value = argument.stringValue;
+            if (spec.precision >= 0 and static_cast<std::size_t>(spec.precision) < value.size())
+                value = value.substr(0, spec.precision);
+
+            pad(out, spec, {}, value, '<');
+            break;
+        }
+        case ArgType::POINTER:
+        {
+            FormatSpec pointerSpec = spec;
+            pointerSpec.type = 'x';
+            pointerSpec.alternate = true;
+            formatInteger(out, pointerSpec, false, argument.unsignedValue);
+            break;
+        }
+    }
+}
+
+#endif // __cpp_lib_format
+
+} // namespace
+
+void formatDeferred(std::string &out, const std::string_view format, const std::string_view arguments)
+{
+    std::array<Argument, MAX_DEFERRED_ARGUMENTS> decoded;
+    const std::size_t count = decodeArguments(arguments, decoded);
+
+    std::size_t nextIndex = 0;
+    std::size_t literalStart = 0;
+    std::string resolved;
+
+    for (std::size_t i = 0; i < format.size(); i++)
+    {
+        const char c = format[i];
+        if (c != '{' and c != '}')
+            continue;
+
+        out.append(format.substr(literalStart, i - literalStart));
+
+        // Escaped braces
+        if (i + 1 < format.size() and format[i + 1] == c)
+        {
+            out += c;
+            literalStart = ++i + 1;
+            continue;
+        }
+
+        const std::size_t close = detail::replacementFieldEnd(format, i);
+        if (c == '}' or close == std::string_view::npos)
+        {
+            // Malformed, the call site was checked so this can only come from a corrupt record
+            out.append(format.substr(i));
+            return;
+        }
+
+        std::string_view field = format.substr(i + 1, close - i - 1);
+        std::size_t index = nextIndex++;
+
+        std::size_t position = 0;
+        if (!field.empty() and field[0] >= '0' and field[0] <= '9')
+        {
+            index = 0;
+            while (position < field.size() and field[position] >= '0' and field[position] <= '9')
+                index = index * 10 + static_cast<std::size_t>(field[position++] - '0');
+        }
+
+        std::string_view spec =
+                position < field.size() and field[position] == ':' ? field.substr(position + 1) : std::string_view{};
+
+        if (spec.find('{') != std::string_view::npos)
+        {
+            resolved.clear();
+            resolveNestedFields(resolved, spec, decoded, count, nextIndex);
+            spec = resolved;
+        }
+
+        if (index < count)
+            formatArgument(out, decoded[index], spec);
+
+        literalStart = close + 1;
+        i = close;
+    }
+
+    out.append(format.substr(literalStart));
+}
+
+} // namespace slog
@@ -0,0 +1,233 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "filerotation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "loggerloc.hpp"
+#include "logindex.hpp"
+
+#ifdef SL_HAS_ZLIB
+#include <zlib.h>
+#endif // SL_HAS_ZLIB
+
+namespace slog
+{
+
+namespace
+{
+
+constexpr std::size_t COMPRESS_CHUNK_SIZE = 64 * 1024;
+
+#ifdef SL_HAS_ZLIB
+bool compressFile(const std::filesystem::path &source, const std::filesystem::path &destination)
+{
+    std::ifstream in(source, std::ios::binary);
+    gzFile out = gzopen(destination.string().c_str(), "wb");
+    if (!in.is_open() or out == nullptr)
+    {
+        if (out != nullptr)
+            gzclose(out);
+        return false;
+    }
+
+    std::array<char, COMPRESS_CHUNK_SIZE> chunk{};
+    bool ok = true;
+    while (ok and in)
+    {
+        in.read(chunk.data(), chunk.size());
+        if (const auto count = static_cast<unsigned>(in.gcount()); count > 0)
+            ok = gzwrite(out, chunk.data(), count) == static_cast<int>(count);
+    }
+
+    return gzclose(out) == Z_OK and ok;
+}
+#endif // SL_HAS_ZLIB
+
+/* Rotated files are named "<active file>.<yyyymmdd-hhmmss>[.n][.gz]", their indexes are handled with them */
+bool isRotatedFile(const std::string &name, const std::string &activeName)
+{
+    if (name.size() <= activeName.size() + 1 or !name.starts_with(activeName + ".") or name.ends_with(LOG_INDEX_SUFFIX))
+        return false;
+
+    const char first = name[activeName.size() + 1];
+    return first >= '0' and first <= '9';
+}
+
+/* Orders rotated files oldest first: by timestamp, then by the ".n" added for files rotated in the same second */
+std::pair<std::string, uint64_t> rotationOrder(const std::filesystem::path &file, const std::string &activeName)
+{
+    std::string suffix = file.filename().string().substr(activeName.size() + 1);
+    if (suffix.ends_with(".gz"))
+        suffix.resize(suffix.size() - 3);
+
+    const auto dot = suffix.find('.');
+    if (dot == std::string::npos)
+        return {suffix, 0};
+
+    uint64_t index = 0;
+    for (const char c: suffix.substr(dot + 1))
+    {
+        if (c >= '0' and c <= '9')
+            index = index * 10 + static_cast<uint64_t>(c - '0');
+    }
+
+    return {suffix.substr(0, dot), index};
+}
+
+} // namespace
+
+std::shared_ptr<RotationWorker> RotationWorker::instance()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<RotationWorker> current;
+
+    std::lock_guard lock(mutex);
+
+    auto worker = current.lock();
+    if (!worker)
+    {
+        worker = std::make_shared<RotationWorker>();
+        current = worker;
+    }
+
+    return worker;
+}
+
+RotationWorker::RotationWorker() : m_thread(&RotationWorker::run, this) {}
+
+RotationWorker::~RotationWorker()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void RotationWorker::schedule(Job job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+
+    m_wake.notify_one();
+}
+
+void RotationWorker::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [&] { return m_jobs.empty() and !m_busy; });
+}
+
+bool RotationWorker::compressionAvailable()
+{
+#ifdef SL_HAS_ZLIB
+    return true;
+#else
+    return false;
+#endif // SL_HAS_ZLIB
+}
+
+void RotationWorker::run()
+{
+    std::unique_lock lock(m_mutex);
+
+    while (true)
+    {
+        m_wake.wait(lock, [&] { return !m_jobs.empty() or m_stop; });
+
+        // Pending jobs are still finished when stopping
+        if (m_jobs.empty())
+            break;
+
+        const Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        m_busy = true;
+
+        lock.unlock();
+        process(job);
+        lock.lock();
+
+        m_busy = false;
+        if (m_jobs.empty())
+            m_idle.notify_all();
+    }
+}
+
+void RotationWorker::process(const Job &job)
+{
+    std::error_code error;
+
+    auto destination = job.activeFile;
+    destination += job.suffix;
+    for (uint32_t i = 1; std::filesystem::exists(destination, error) or
+                         std::filesystem::exists(std::filesystem::path(destination).concat(".gz"), error);
+         i++)
+    {
+        destination = job.activeFile;
+        destination += job.suffix + "." + std::to_string(i);
+    }
+
+    std::filesystem::rename(job.rotatedFile, destination, error);
+    if (error)
+    {
+        // Left under its temporary name, which retention doesn't count as a destination file
+        reportLoggerError("Could not rename " + job.rotatedFile.string() + " to " + destination.string() + ": " +
+                          error.message());
+        return;
+    }
+
+    if (std::filesystem::exists(logIndexPath(job.rotatedFile), error))
+        std::filesystem::rename(logIndexPath(job.rotatedFile), logIndexPath(destination), error);
+
+#ifdef SL_HAS_ZLIB
+    if (job.compress)
+    {
+        auto compressed = destination;
+        compressed += ".gz";
+
+        // The index's offsets are into the uncompressed file, it goes with it
+        if (compressFile(destination, compressed))
+        {
+            std::filesystem::remove(destination, error);
+            std::filesystem::remove(logIndexPath(destination), error);
+        }
+        else
+            std::filesystem::remove(compressed, error);
+    }
+#endif // SL_HAS_ZLIB
+
+    if (job.maxFiles == 0)
+        return;
+
+    const auto directory = job.activeFile.has_parent_path() ? job.activeFile.parent_path() : ".";
+    const std::string activeName = job.activeFile.filename().string();
+
+    std::vector<std::filesystem::path> rotated;
+    for (const auto &entry: std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file(error) and isRotatedFile(entry.path().filename().string(), activeName))
+            rotated.push_back(entry.path());
+    }
+
+    if (rotated.size() <= job.maxFiles)
+        return;
+
+    std::ranges::sort(rotated, {}, [&](const auto &file) { return rotationOrder(file, activeName); });
+    for (std::size_t i = 0; i < rotated.size() - job.maxFiles; i++)
+    {
+        std::filesystem::remove(rotated[i], error);
+        std::filesystem::remove(logIndexPath(rotated[i]), error);
+    }
+}
+
+} // namespace slog
@@ -0,0 +1,515 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "flightrecorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "structuredlog.hpp"
+
+namespace slog
+{
+
+constexpr uint32_t FLIGHT_RECORDER_VERSION = 1;
+
+struct FlightRecorder::Header
+{
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t slotSize;
+    uint64_t slotCount;
+    /* Sequence number the next record gets, slot = sequence % slotCount */
+    std::atomic<uint64_t> next;
+    int64_t pid;
+    std::array<char, 24> reserved;
+};
+
+struct FlightRecorder::Slot
+{
+    /* 2 * sequence + 1 while being written, 2 * sequence + 2 once complete, 0 if never used */
+    std::atomic<uint64_t> sequence;
+    int64_t nanoseconds;
+    uint32_t threadId;
+    uint16_t length;
+    int8_t level;
+    uint8_t threadNameLength;
+    std::array<char, MAX_THREAD_NAME_LENGTH + 1> threadName;
+
+    /* The message follows the slot header */
+    char *text() { return reinterpret_cast<char *>(this + 1); }
+    [[nodiscard]] const char *text() const { return reinterpret_cast<const char *>(this + 1); }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The recorder is shared with signal handlers and readers");
+
+namespace
+{
+
+std::array<std::atomic<FlightRecorder *>, MAX_FLIGHT_RECORDERS> s_recorders{};
+std::atomic<bool> s_dumped = false;
+
+constexpr std::array CRASH_SIGNALS = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+std::array<struct sigaction, CRASH_SIGNALS.size()> s_previousActions{};
+std::atomic<bool> s_handlersInstalled = false;
+
+/* Room for the dump (a 1 KiB line and a few frames) with plenty to spare */
+constexpr std::size_t MIN_SIGNAL_STACK_SIZE = 64 * 1024;
+
+/* The thread's alternate signal stack, disabled again before it's freed when the thread exits */
+struct AlternateStack
+{
+    bool prepared = false;
+    void *memory = nullptr;
+    std::size_t size = 0;
+
+    ~AlternateStack()
+    {
+        if (memory == nullptr)
+            return;
+
+        stack_t disabled{};
+        disabled.ss_flags = SS_DISABLE;
+        sigaltstack(&disabled, nullptr);
+        munmap(memory, size);
+    }
+};
+
+thread_local AlternateStack t_alternateStack;
+
+/* Level names padded like formatLogLine pads them, a lookup the signal handler can do without allocating */
+constexpr std::array<std::string_view, 6> PADDED_LEVEL_NAMES = {"   NONE", "  DEBUG", "   INFO",
+                                                                "WARNING", "  ERROR", "  FATAL"};
+
+void crashHandler(const int signal)
+{
+    FlightRecorder::dumpAll(STDERR_FILENO);
+
+    // Hand the signal to whoever had it before us, the default action kills the process as usual
+    for (std::size_t i = 0; i < CRASH_SIGNALS.size(); i++)
+    {
+        if (CRASH_SIGNALS[i] == signal)
+            sigaction(signal, &s_previousActions[i], nullptr);
+    }
+
+    raise(signal);
+}
+
+void installCrashHandlers()
+{
+    struct sigaction action{};
+    action.sa_handler = crashHandler;
+    action.sa_flags = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+
+    for (std::size_t i = 0; i < CRASH_SIGNALS.size(); i++)
+        sigaction(CRASH_SIGNALS[i], &action, &s_previousActions[i]);
+
+    s_handlersInstalled.store(true, std::memory_order_release);
+}
+
+/* Minimal formatting for the signal handler, everything goes into a fixed buffer */
+struct SignalSafeLine
+{
+    std::array<char, 1024> data;
+    std::size_t length = 0;
+
+    void append(const char *text, const std::size_t size)
+    {
+        const std::size_t count = std::min(size, data.size() - length);
+        std::memcpy(data.data() + length, text, count);
+        length += count;
+    }
+
+    void append(const std::string_view text) { append(text.data(), text.size()); }
+
+    void appendNumber(uint64_t value, const int width)
+    {
+        std::array<char, 20> digits{};
+        int count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0 or count < width);
+
+        while (count > 0 and length < data.size())
+            data[length++] = digits[--count];
+    }
+
+    /* Same layout as formatTime but always UTC, localtime isn't async-signal-safe */
+    void appendTime(const int64_t nanoseconds)
+    {
+        constexpr int64_t NANOSECONDS_PER_DAY = 86'400'000'000'000;
+        int64_t days = nanoseconds / NANOSECONDS_PER_DAY;
+        int64_t ofDay = nanoseconds % NANOSECONDS_PER_DAY;
+        if (ofDay < 0)
+        {
+            ofDay += NANOSECONDS_PER_DAY;
+            days--;
+        }
+
+        // Days since the epoch to a civil date (Howard Hinnant's algorithm)
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const auto dayOfEra = static_cast<uint64_t>(days - era * 146097);
+        const uint64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const uint64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const uint64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+        const uint64_t day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+        const uint64_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+        const auto year = static_cast<uint64_t>(static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0));
+
+        const auto milliseconds = static_cast<uint64_t>(ofDay / 1'000'000);
+
+        appendNumber(day, 2);
+        append("/", 1);
+        appendNumber(month, 2);
+        append("/", 1);
+        appendNumber(year, 4);
+        append(" ", 1);
+        appendNumber(milliseconds / 3'600'000, 2);
+        append(":", 1);
+        appendNumber(milliseconds / 60'000 % 60, 2);
+        append(":", 1);
+        appendNumber(milliseconds / 1'000 % 60, 2);
+        append(".", 1);
+        appendNumber(milliseconds % 1'000, 3);
+        append(" UTC", 4);
+    }
+
+    void write(const int fd) const
+    {
+        std::size_t written = 0;
+        while (written < length)
+        {
+            const ssize_t result = ::write(fd, data.data() + written, length - written);
+            if (result < 0 and errno == EINTR)
+                continue;
+            if (result <= 0)
+                return;
+
+            written += static_cast<std::size_t>(result);
+        }
+    }
+};
+
+} // namespace
+
+FlightRecorder::FlightRecorder(const std::string &filename, const std::size_t slotCount, const std::size_t slotSize,
+                               const bool removeOnClose) :
+    m_filename(filename), m_removeOnClose(removeOnClose), m_slotSize(std::max(slotSize, sizeof(Slot) + 16)),
+    m_slotCount(std::max<std::size_t>(slotCount, 1))
+{
+    /* slog-recover reads the layout field by field from these offsets */
+    static_assert(sizeof(Header) == 64 and offsetof(Header, slotCount) == 16);
+    static_assert(sizeof(Slot) == 40 and offsetof(Slot, threadId) == 16 and offsetof(Slot, length) == 20 and
+                  offsetof(Slot, level) == 22 and offsetof(Slot, threadNameLength) == 23 and
+                  offsetof(Slot, threadName) == 24);
+
+    // Keep every slot header 8 byte aligned
+    m_slotSize = (m_slotSize + 7) & ~static_cast<std::size_t>(7);
+    m_mappingSize = sizeof(Header) + m_slotCount * m_slotSize;
+
+    const int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw LogException("Could not open flight recorder file: " + filename + " (" + std::strerror(errno) + ")");
+
+    const auto size = static_cast<off_t>(m_mappingSize);
+    if (posix_fallocate(fd, 0, size) != 0 and ftruncate(fd, size) != 0)
+    {
+        ::close(fd);
+        throw LogException("Could not allocate flight recorder file: " + filename);
+    }
+
+    void *mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+
+    if (mapping == MAP_FAILED)
+        throw LogException("Could not map flight recorder file: " + filename + " (" + std::strerror(errno) + ")");
+
+    m_mapping = static_cast<char *>(mapping);
+    m_header = new (m_mapping) Header{};
+    m_header->version = FLIGHT_RECORDER_VERSION;
+    m_header->slotSize = static_cast<uint32_t>(m_slotSize);
+    m_header->slotCount = m_slotCount;
+    m_header->pid = getpid();
+
+    for (std::size_t i = 0; i < m_slotCount; i++)
+        new (m_mapping + sizeof(Header) + i * m_slotSize) Slot{};
+
+    // The magic goes in last, a reader never sees a half initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = FLIGHT_RECORDER_MAGIC;
+
+    // Record everything by default, the point is having the detail the other loggers filter out
+    m_minLogLevel = LogLevel::DEBUG;
+
+    static std::once_flag handlersInstalled;
+    std::call_once(handlersInstalled, installCrashHandlers);
+    prepareThread();
+
+    for (auto &recorder: s_recorders)
+    {
+        FlightRecorder *expected = nullptr;
+        if (recorder.compare_exchange_strong(expected, this))
+            break;
+    }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    for (auto &recorder: s_recorders)
+    {
+        FlightRecorder *expected = this;
+        recorder.compare_exchange_strong(expected, nullptr);
+    }
+
+    munmap(m_mapping, m_mappingSize);
+
+    if (m_removeOnClose)
+        ::unlink(m_filename.c_str());
+}
+
+void FlightRecorder::log(const std::string &message, const LogLevel level)
+{
+    logRecord(makeRecord(level, message));
+}
+
+void FlightRecorder::exception(const LogException &exception)
+{
+    std::string error = "Uncaught Exception Occurred! ";
+    error += exception.what();
+
+    log(error, LogLevel::FATAL);
+}
+
+FlightRecorder::Slot *FlightRecorder::slot(const uint64_t sequence) const
+{
+    return reinterpret_cast<Slot *>(m_mapping + sizeof(Header) + (sequence % m_slotCount) * m_slotSize);
+}
+
+void FlightRecorder::logRecord(const LogRecord &record)
+{
+    if (record.level < m_minLogLevel or record.level > m_maxLogLevel)
+        return;
+
+    if (!t_alternateStack.prepared) [[unlikely]]
+        prepareThread();
+
+    const uint64_t sequence = m_header->next.fetch_add(1, std::memory_order_relaxed);
+    Slot *target = slot(sequence);
+
+    target->sequence.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    /* Fields are kept as logfmt text after the message, formatted into a buffer each thread reuses */
+    thread_local std::string withFields;
+    std::string_view message = record.message;
+    if (!record.fields.empty())
+    {
+        withFields = record.message;
+        formatLogfmtFields(withFields, record.fields);
+        message = withFields;
+    }
+
+    const std::size_t length = std::min(message.size(), m_slotSize - sizeof(Slot));
+    target->nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch()).count();
+    target->threadId = record.threadId;
+    target->threadNameLength = record.threadName.length;
+    std::copy_n(record.threadName.data.begin(), record.threadName.length, target->threadName.begin());
+    target->level = static_cast<int8_t>(record.level);
+    target->length = static_cast<uint16_t>(length);
+    std::memcpy(target->text(), message.data(), length);
+    metrics().addBytes(length);
+
+    target->sequence.store(2 * sequence + 2, std::memory_order_release);
+}
+
+void FlightRecorder::dump(const int fd) const noexcept
+{
+    const uint64_t next = m_header->next.load(std::memory_order_acquire);
+    const uint64_t first = next > m_slotCount ? next - m_slotCount : 0;
+
+    SignalSafeLine line;
+    line.append("--- Flight recorder ");
+    line.append(m_filename);
+    line.append(", last ");
+    line.appendNumber(next - first, 1);
+    line.append(" records ---\n");
+    line.write(fd);
+
+    for (uint64_t sequence = first; sequence < next; sequence++)
+    {
+        const Slot *source = slot(sequence);
+        const uint64_t before = source->sequence.load(std::memory_order_acquire);
+        if (before != 2 * sequence + 2)
+            continue; // Being written or already overwritten
+
+        const auto level = static_cast<std::size_t>(source->level + 1);
+
+        line.length = 0;
+        line.append("[");
+        line.appendTime(source->nanoseconds);
+        line.append(" ");
+        line.append(level < PADDED_LEVEL_NAMES.size() ? PADDED_LEVEL_NAMES[level] : "UNKNOWN");
+        line.append("]");
+        if (source->threadId != 0)
+        {
+            line.append(" [");
+            line.appendNumber(source->threadId, 1);
+            if (source->threadNameLength != 0)
+            {
+                line.append(" ");
+                line.append(source->threadName.data(),
+                            std::min<std::size_t>(source->threadNameLength, MAX_THREAD_NAME_LENGTH));
+            }
+            line.append("]");
+        }
+        line.append(": ");
+        line.append(source->text(), std::min<std::size_t>(source->length, m_slotSize - sizeof(Slot)));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source->sequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        // Always end the line, even if the message filled the buffer
+        line.length = std::min(line.length, line.data.size() - 1);
+        line.append("\n");
+        line.write(fd);
+    }
+}
+
+void FlightRecorder::dumpAll(const int fd) noexcept
+{
+    if (s_dumped.exchange(true))
+        return;
+
+    for (const auto &recorder: s_recorders)
+    {
+        if (const auto *current = recorder.load(std::memory_order_acquire); current != nullptr)
+            current->dump(fd);
+    }
+}
+
+void FlightRecorder::prepareThread() noexcept
+{
+    if (t_alternateStack.prepared or !s_handlersInstalled.load(std::memory_order_acquire))
+        return;
+
+    t_alternateStack.prepared = true;
+
+    // A thread that already has one, set up by the program, keeps it
+    stack_t current{};
+    if (sigaltstack(nullptr, &current) == 0 and (current.ss_flags & SS_DISABLE) == 0)
+        return;
+
+    const std::size_t size = std::max<std::size_t>(SIGSTKSZ, MIN_SIGNAL_STACK_SIZE);
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return;
+
+    stack_t stack{};
+    stack.ss_sp = memory;
+    stack.ss_size = size;
+    if (sigaltstack(&stack, nullptr) != 0)
+    {
+        munmap(memory, size);
+        return;
+    }
+
+    t_alternateStack.memory = memory;
+    t_alternateStack.size = size;
+}
+
+std::vector<LogRecord> FlightRecorder::recover(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        throw LogException("Could not open file: " + filename);
+
+    const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    const std::string_view magic(FLIGHT_RECORDER_MAGIC.data(), FLIGHT_RECORDER_MAGIC.size());
+
+    const auto read = [&contents]<typename T>(const std::size_t position, T &value)
+    { std::memcpy(&value, contents.data() + position, sizeof(T)); };
+
+    // A recorder file starts with the header, in a core dump it's wherever the mapping ended up
+    for (std::size_t offset = contents.find(magic); offset != std::string::npos;
+         offset = contents.find(magic, offset + 1))
+    {
+        if (offset % alignof(Header) != 0 or contents.size() - offset < sizeof(Header))
+            continue;
+
+        uint32_t version = 0;
+        uint32_t slotSize = 0;
+        uint64_t slotCount = 0;
+        read(offset + 8, version);
+        read(offset + 12, slotSize);
+        read(offset + 16, slotCount);
+
+        if (version != FLIGHT_RECORDER_VERSION or slotSize < sizeof(Slot) or slotSize % 8 != 0 or slotCount == 0 or
+            slotCount > (contents.size() - offset - sizeof(Header)) / slotSize)
+        {
+            continue;
+        }
+
+        std::vector<std::pair<uint64_t, LogRecord>> found;
+        for (uint64_t i = 0; i < slotCount; i++)
+        {
+            const std::size_t position = offset + sizeof(Header) + i * slotSize;
+
+            uint64_t sequence = 0;
+            int64_t nanoseconds = 0;
+            uint32_t threadId = 0;
+            uint16_t length = 0;
+            int8_t level = 0;
+            uint8_t threadNameLength = 0;
+            read(position, sequence);
+            read(position + 8, nanoseconds);
+            read(position + 16, threadId);
+            read(position + 20, length);
+            read(position + 22, level);
+            read(position + 23, threadNameLength);
+
+            if (sequence == 0 or sequence % 2 != 0 or (sequence / 2 - 1) % slotCount != i)
+                continue; // Unused or torn by the crash
+
+            LogRecord record;
+            record.level = static_cast<LogLevel>(level);
+            record.timestamp = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::nanoseconds(nanoseconds)));
+            record.threadId = threadId;
+            const std::size_t nameLength = std::min<std::size_t>(threadNameLength, MAX_THREAD_NAME_LENGTH);
+            record.threadName = ThreadName(std::string_view(contents.data() + position + 24, nameLength));
+            record.message.assign(contents.data() + position + sizeof(Slot),
+                                  std::min<std::size_t>(length, slotSize - sizeof(Slot)));
+
+            found.emplace_back(sequence, std::move(record));
+        }
+
+        std::ranges::sort(found, {}, &std::pair<uint64_t, LogRecord>::first);
+
+        std::vector<LogRecord> records;
+        records.reserve(found.size());
+        for (auto &[sequence, record]: found)
+            records.push_back(std::move(record));
+
+        return records;
+    }
+
+    throw LogException("No flight recorder found in " + filename);
+}
+
+} // namespace slog
@@ -0,0 +1,528 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "logconfig.hpp"
+
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <ranges>
+#include <sstream>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+#include "category.hpp"
+#include "simplelogger.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() and std::isspace(static_cast<unsigned char>(text.front())))
+        text.remove_prefix(1);
+    while (!text.empty() and std::isspace(static_cast<unsigned char>(text.back())))
+        text.remove_suffix(1);
+
+    return text;
+}
+
+bool equalsIgnoreCase(const std::string_view a, const std::string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+
+    return true;
+}
+
+std::optional<LogLevel> parseLevel(const std::string_view value)
+{
+    for (const LogLevel level: {LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARNING, LogLevel::ERROR, LogLevel::FATAL})
+    {
+        if (equalsIgnoreCase(value, levelName(level)))
+            return level;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<uint64_t> parseNumber(const std::string_view value)
+{
+    uint64_t number = 0;
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (error != std::errc() or end != value.data() + value.size())
+        return std::nullopt;
+
+    return number;
+}
+
+class ConfigParser
+{
+public:
+    LogConfig parse(std::string_view text)
+    {
+        while (!text.empty())
+        {
+            const auto newline = text.find('\n');
+            std::string_view line = text.substr(0, newline);
+            text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+            m_line++;
+
+            // Comments run to the end of the line
+            line = trim(line.substr(0, line.find_first_of("#;")));
+            if (line.empty())
+                continue;
+
+            if (line.front() == '[')
+                parseSection(line);
+            else
+                parseSetting(line);
+        }
+
+        for (const auto &[name, file]: m_config.files)
+        {
+            if (file.path.empty())
+                throw LogException("Log config: [file " + name + "] has no path");
+        }
+
+        return std::move(m_config);
+    }
+
+private:
+    enum class Section
+    {
+        GLOBAL,
+        CATEGORY,
+        LOGGER,
+        FILE
+    };
+
+    LogConfig m_config;
+    std::size_t m_line = 0;
+
+    Section m_section = Section::GLOBAL;
+    std::string m_name;
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw LogException("Log config line " + std::to_string(m_line) + ": " + message);
+    }
+
+    void parseSection(const std::string_view line)
+    {
+        if (line.back() != ']')
+            fail("section header needs a closing ]");
+
+        const std::string_view header = trim(line.substr(1, line.size() - 2));
+        const auto space = header.find_first_of(" \t");
+        const std::string_view type = header.substr(0, space);
+        m_name = space == std::string_view::npos ? std::string() : std::string(trim(header.substr(space)));
+
+        if (m_name.empty())
+            fail("section needs a name, [category name], [logger name] or [file name]");
+
+        if (type == "category")
+        {
+            m_section = Section::CATEGORY;
+        }
+        else if (type == "logger")
+        {
+            m_section = Section::LOGGER;
+            m_config.loggers[m_name];
+        }
+        else if (type == "file")
+        {
+            m_section = Section::FILE;
+            m_config.files[m_name];
+        }
+        else
+        {
+            fail("unknown section \"" + std::string(type) + "\"");
+        }
+    }
+
+    void parseSetting(const std::string_view line)
+    {
+        const auto equals = line.find('=');
+        if (equals == std::string_view::npos)
+            fail("expected key = value");
+
+        const std::string_view key = trim(line.substr(0, equals));
+        const std::string_view value = trim(line.substr(equals + 1));
+        if (key.empty() or value.empty())
+            fail("expected key = value");
+
+        switch (m_section)
+        {
+            case Section::GLOBAL:
+                if (key == "level")
+                    m_config.minLevel = level(value);
+                else if (key == "max_level")
+                    m_config.maxLevel = level(value);
+                else
+                    unknownKey(key);
+                break;
+            case Section::CATEGORY:
+                if (key != "level")
+                    unknownKey(key);
+                m_config.categories[m_name] = level(value);
+                break;
+            case Section::LOGGER:
+                parseLoggerSetting(m_config.loggers[m_name], key, value);
+                break;
+            case Section::FILE:
+            {
+                FileConfig &file = m_config.files[m_name];
+                if (key == "path")
+                    file.path = value;
+                else if (key == "mode" and (value == "append" or value == "overwrite"))
+                    file.mode = value == "append" ? LogFileMode::APPEND : LogFileMode::OVERWRITE;
+                else if (key == "mode")
+                    fail("mode is append or overwrite");
+                else
+                    parseLoggerSetting(file.logger, key, value);
+                break;
+            }
+        }
+    }
+
+    void parseLoggerSetting(LoggerConfig &logger, const std::string_view key, const std::string_view value)
+    {
+        if (key == "level")
+        {
+            logger.minLevel = level(value);
+            return;
+        }
+        if (key == "max_level")
+        {
+            logger.maxLevel = level(value);
+            return;
+        }
+
+        // Flush settings start from the default policy
+        if (!logger.flushPolicy.has_value() and (key.starts_with("flush") or key == "buffer_size"))
+            logger.flushPolicy = FlushPolicy{};
+
+        if (key == "flush" and (value == "always" or value == "buffered"))
+            logger.flushPolicy->mode = value == "always" ? FlushMode::ALWAYS : FlushMode::BUFFERED;
+        else if (key == "flush")
+            fail("flush is always or buffered");
+        else if (key == "buffer_size")
+            logger.flushPolicy->bufferSize = number(value);
+        else if (key == "flush_bytes")
+            logger.flushPolicy->flushBytes = number(value);
+        else if (key == "flush_interval_ms")
+            logger.flushPolicy->flushInterval = std::chrono::milliseconds(number(value));
+        else if (key == "flush_level")
+            logger.flushPolicy->flushLevel = level(value);
+        else
+            unknownKey(key);
+    }
+
+    LogLevel level(const std::string_view value) const
+    {
+        const auto parsed = parseLevel(value);
+        if (!parsed.has_value())
+            fail("\"" + std::string(value) + "\" isn't a level, use DEBUG, INFO, WARNING, ERROR or FATAL");
+
+        return *parsed;
+    }
+
+    uint64_t number(const std::string_view value) const
+    {
+        const auto parsed = parseNumber(value);
+        if (!parsed.has_value())
+            fail("\"" + std::string(value) + "\" isn't a number");
+
+        return *parsed;
+    }
+
+    [[noreturn]] void unknownKey(const std::string_view key) const
+    {
+        fail("unknown key \"" + std::string(key) + "\"");
+    }
+};
+
+void configureLogger(LoggerLoc &loggerLoc, const LoggerConfig &config)
+{
+    if (config.minLevel.has_value())
+        loggerLoc.setMinLogLevel(*config.minLevel);
+    if (config.maxLevel.has_value())
+        loggerLoc.setMaxLogLevel(*config.maxLevel);
+
+    if (config.flushPolicy.has_value())
+    {
+        if (auto *file = dynamic_cast<FileLogger *>(&loggerLoc))
+            file->setFlushPolicy(*config.flushPolicy);
+        else if (auto *console = dynamic_cast<ConsoleLogger *>(&loggerLoc))
+            console->setFlushPolicy(*config.flushPolicy);
+        else if (auto *simpleConsole = dynamic_cast<SimpleConsoleLogger *>(&loggerLoc))
+            simpleConsole->setFlushPolicy(*config.flushPolicy);
+    }
+}
+
+#ifdef __linux__
+/* Watches the directory, editors often replace the file instead of writing to it. False if inotify isn't usable. */
+bool watchWithInotify(const std::filesystem::path &path, const std::atomic<bool> &stop,
+                      const std::function<void()> &started, const std::function<void()> &changed)
+{
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : ".";
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    const std::string filename = path.filename().string();
+    alignas(inotify_event) std::array<char, 4096> events{};
+
+    started();
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+        pollfd pollFd{fd, POLLIN, 0};
+        if (poll(&pollFd, 1, static_cast<int>(CONFIG_POLL_INTERVAL.count())) <= 0)
+            continue;
+
+        bool modified = false;
+        ssize_t length = 0;
+        while ((length = read(fd, events.data(), events.size())) > 0)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto *event = reinterpret_cast<const inotify_event *>(events.data() + offset);
+                if (event->len != 0 and filename == event->name)
+                    modified = true;
+
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+
+        if (modified)
+            changed();
+    }
+
+    close(fd);
+    return true;
+}
+#endif // __linux__
+
+void watchModificationTime(const std::filesystem::path &path, const std::atomic<bool> &stop,
+                           const std::function<void()> &started, const std::function<void()> &changed)
+{
+    std::error_code error;
+    auto lastWrite = std::filesystem::last_write_time(path, error);
+
+    started();
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(CONFIG_POLL_INTERVAL);
+
+        const auto writeTime = std::filesystem::last_write_time(path, error);
+        if (!error and writeTime != lastWrite)
+        {
+            lastWrite = writeTime;
+            changed();
+        }
+    }
+}
+
+} // namespace
+
+LogConfig LogConfig::parse(const std::string_view text) { return ConfigParser().parse(text); }
+
+LogConfig LogConfig::load(const std::filesystem::path &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        throw LogException("Could not open log config: " + path.string());
+
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str());
+}
+
+ConfigWatcher::ConfigWatcher(std::filesystem::path path, SimpleLogger *logger) :
+    m_path(std::move(path)), m_logger(logger != nullptr ? logger : SimpleLogger::GlobalLogger())
+{
+    if (auto console = std::dynamic_pointer_cast<ConsoleLogger>(m_logger->getLogger(0)))
+        m_loggers["console"] = console;
+}
+
+ConfigWatcher::~ConfigWatcher() { stop(); }
+
+void ConfigWatcher::registerLogger(const std::string &name, const std::shared_ptr<LoggerLoc> &loggerLoc)
+{
+    std::lock_guard lock(m_mutex);
+    m_loggers[name] = loggerLoc;
+}
+
+bool ConfigWatcher::reload()
+{
+    std::shared_ptr<const LogConfig> config;
+    try
+    {
+        config = std::make_shared<const LogConfig>(LogConfig::load(m_path));
+    }
+    catch (const LogException &exception)
+    {
+        m_logger->log(std::string("Keeping the current log config, ") + exception.what(), LogLevel::ERROR);
+        return false;
+    }
+
+    std::lock_guard lock(m_mutex);
+
+    apply(*config);
+    m_current = std::move(config);
+
+    m_logger->log("Applied log config " + m_path.string(), LogLevel::INFO);
+    return true;
+}
+
+void ConfigWatcher::start()
+{
+    if (m_thread.joinable())
+    {
+        reload();
+        return;
+    }
+
+    // The first reload happens once the watch is in place, so no change in between is missed
+    std::promise<void> started;
+    std::future<void> applied = started.get_future();
+
+    m_stop.store(false, std::memory_order_release);
+    m_thread = std::thread(&ConfigWatcher::watch, this, std::move(started));
+
+    applied.wait();
+}
+
+void ConfigWatcher::stop()
+{
+    m_stop.store(true, std::memory_order_release);
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+std::shared_ptr<const LogConfig> ConfigWatcher::current() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_current;
+}
+
+void ConfigWatcher::apply(const LogConfig &config)
+{
+    /* Setting by setting, each one is atomic on its own but the reload as a whole isn't (see ConfigWatcher) */
+    if (config.minLevel.has_value())
+        m_logger->setMinLogLevel(*config.minLevel);
+    if (config.maxLevel.has_value())
+        m_logger->setMaxLogLevel(*config.maxLevel);
+
+    // Categories the previous config set and this one doesn't inherit their level again
+    if (m_current != nullptr)
+    {
+        for (const auto &name: m_current->categories | std::views::keys)
+        {
+            if (!config.categories.contains(name))
+                Category::get(name).inheritLevel();
+        }
+    }
+
+    for (const auto &[name, level]: config.categories)
+        Category::get(name).setLevel(level);
+
+    for (const auto &[name, loggerConfig]: config.loggers)
+    {
+        if (const auto found = m_loggers.find(name); found != m_loggers.end())
+            configureLogger(*found->second, loggerConfig);
+        else
+            m_logger->log("Log config names logger \"" + name + "\", which isn't registered", LogLevel::WARNING);
+    }
+
+    // New files are added before old ones are removed, so no record falls between them
+    std::map<std::string, std::shared_ptr<FileLogger>, std::less<>> files;
+    for (const auto &[name, fileConfig]: config.files)
+    {
+        std::shared_ptr<FileLogger> file;
+        if (const auto found = m_files.find(name); found != m_files.end())
+        {
+            const FileConfig &previous = m_current->files.find(name)->second;
+            if (previous.path == fileConfig.path and previous.mode == fileConfig.mode)
+                file = found->second;
+        }
+
+        const bool opened = file == nullptr;
+        if (opened)
+        {
+            try
+            {
+                file = std::make_shared<FileLogger>(fileConfig.path.string(), fileConfig.mode);
+            }
+            catch (const LogException &exception)
+            {
+                m_logger->log(exception.what(), LogLevel::ERROR);
+                continue;
+            }
+        }
+
+        // Files belong to the config, settings it leaves out go back to their defaults
+        LoggerConfig settings = fileConfig.logger;
+        settings.minLevel = settings.minLevel.value_or(LogLevel::INFO);
+        settings.maxLevel = settings.maxLevel.value_or(LogLevel::FATAL);
+        settings.flushPolicy = settings.flushPolicy.value_or(FlushPolicy{});
+        configureLogger(*file, settings);
+
+        if (opened)
+            m_logger->addLogger(file);
+
+        files[name] = file;
+    }
+
+    for (const auto &[name, file]: m_files)
+    {
+        if (const auto kept = files.find(name); kept == files.end() or kept->second != file)
+            m_logger->removeLogger(file);
+    }
+
+    m_files = std::move(files);
+}
+
+void ConfigWatcher::watch(std::promise<void> started)
+{
+    const auto changed = [this] { reload(); };
+    const auto applyFirst = [&]
+    {
+        reload();
+        started.set_value();
+    };
+
+#ifdef __linux__
+    if (watchWithInotify(m_path, m_stop, applyFirst, changed))
+        return;
+#endif // __linux__
+
+    watchModificationTime(m_path, m_stop, applyFirst, changed);
+}
+
+} // namespace slog
@@ -1,105 +1,118 @@
 /* Created by Matthew Brown on 6/15/2024 */
 #include "loggerloc.hpp"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <chrono>
 #include <ctime>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
-#include <unordered_map>
-
-constexpr auto DEBUG_COLOR = "\033[34m";
-constexpr auto INFO_COLOR = "\033[32m";
-constexpr auto WARNING_COLOR = "\033[33m";
-constexpr auto ERROR_COLOR = "\033[31m";
-constexpr auto FATAL_COLOR = "\033[41m";
-constexpr auto RESET_COLOR = "\033[0m";
+
+#include "filerotation.hpp"
+#include "repeatfilter.hpp"
+#include "structuredlog.hpp"
+#include "timestamp.hpp"
 
 namespace slog
 {
 
-std::unordered_map<LogLevel, std::string> LogLevelColors = {
-        {LogLevel::NONE, RESET_COLOR},      {LogLevel::DEBUG, DEBUG_COLOR}, {LogLevel::INFO, INFO_COLOR},
-        {LogLevel::WARNING, WARNING_COLOR}, {LogLevel::ERROR, ERROR_COLOR}, {LogLevel::FATAL, FATAL_COLOR}};
+std::string getLogName(const LogLevel level) { return std::string(levelName(level)); }
 
-std::unordered_map<LogLevel, std::string> LogLevelNames = {{LogLevel::NONE, "NONE"},   {LogLevel::DEBUG, "DEBUG"},
-                                                           {LogLevel::INFO, "INFO"},   {LogLevel::WARNING, "WARNING"},
-                                                           {LogLevel::ERROR, "ERROR"}, {LogLevel::FATAL, "FATAL"}};
+std::string formatStringFromLeft(const std::string &name, const uint32_t size)
+{
+    std::string formattedName;
+    if (name.size() < size)
+        formattedName.append(size - name.size(), ' ');
 
-std::string getLogName(const LogLevel level) { return LogLevelNames[level]; }
+    formattedName += name;
+    return formattedName;
+}
 
-std::string formatStringFromLeft(const std::string &name, uint32_t size)
+void formatLogLine(std::string &out, const LogRecord &record)
 {
-    std::string formattedName = name;
+    CompiledPattern<DEFAULT_FILE_PATTERN>::format(out, record, {});
+}
 
-    if (name.size() < size)
+void formatThread(std::string &out, const LogRecord &record)
+{
+    if (record.threadId == 0)
+        return;
+
+    std::array<char, 16> digits{};
+    char *end = std::to_chars(digits.data(), digits.data() + digits.size(), record.threadId).ptr;
+
+    out += " [";
+    out.append(digits.data(), static_cast<std::size_t>(end - digits.data()));
+    if (!record.threadName.empty())
     {
-        formattedName = std::string(size - name.size(), ' ') + name;
+        out += ' ';
+        out += record.threadName.view();
     }
-
-    return formattedName;
+    out += ']';
 }
 
-std::string LoggerLoc::getTime()
+namespace
 {
-    static constexpr int MAX_DATE_LENGTH = 11;
 
-    // Get the current time
-    std::stringstream ss;
-    const auto now = std::chrono::system_clock::now();
-    auto t = now.time_since_epoch();
+/* Errors go to stderr, everything else to stdout */
+ConsoleStream consoleStream(const LogLevel level)
+{
+    return level < LogLevel::ERROR ? ConsoleStream::STDOUT : ConsoleStream::STDERR;
+}
 
-    // Get the current date
-    const auto date = std::chrono::system_clock::to_time_t(now);
-    char dateString[MAX_DATE_LENGTH];
-    std::strftime(&dateString[0], MAX_DATE_LENGTH, "%d/%m/%Y", std::localtime(&date));
+} // namespace
 
-    ss << dateString << " ";
+std::string LoggerLoc::getTime() { return getTime(std::chrono::system_clock::now()); }
 
-    ss << std::setfill('0') << (std::chrono::duration_cast<std::chrono::hours>(t) % 24).count();
-    ss << ":";
-    ss << std::setfill('0') << std::setw(2) << (std::chrono::duration_cast<std::chrono::minutes>(t) % 60).count();
-    ss << ":";
-    ss << std::setfill('0') << std::setw(2) << (std::chrono::duration_cast<std::chrono::seconds>(t) % 60).count();
-    ss << ".";
-    ss << std::setfill('0') << std::setw(3)
-       << (std::chrono::duration_cast<std::chrono::milliseconds>(t) % 1000).count();
+std::string LoggerLoc::getTime(const std::chrono::system_clock::time_point time)
+{
+    return std::string(formatTime(time).view());
+}
 
-    return ss.str();
+FormattedTime LoggerLoc::getTime(const LogRecord &record)
+{
+    return record.time.empty() ? formatTime(record.timestamp) : record.time;
 }
 
 void SimpleConsoleLogger::log(const std::string &message, const LogLevel level)
 {
-    if (level < m_minLogLevel or level > m_maxLogLevel)
-        return;
+    logRecord(makeRecord(level, message));
+}
 
-    std::stringstream out;
+void SimpleConsoleLogger::logRecord(const LogRecord &record)
+{
+    const LogLevel level = record.level;
 
-    if (m_color)
-        out << LogLevelColors[level];
+    if (level < m_minLogLevel or level > m_maxLogLevel)
+        return;
 
-    out << std::endl;
-    out << "[" << getTime() << " ";
-    out << formatStringFromLeft(LogLevelNames[level], MAX_LOG_LEVEL_NAME_LENGTH);
-    out << "]: ";
+    const ConsoleStream stream = consoleStream(level);
+    const bool terminal = !m_detectTerminal or isConsoleTerminal(stream);
+    const bool color = m_color and terminal;
 
-    out << message;
-    out << "  "; // Some spacing
+    std::lock_guard lock(m_mutex);
 
-    if (m_color)
-        out << RESET_COLOR;
+    std::string &line = m_output.nextLine();
 
-    if (level < LogLevel::ERROR)
+    // The leading newline and trailing spacing only look right on a terminal, pipes and files get plain lines
+    if (!terminal)
     {
-        // Try to make sure output is properly flushed
-        std::cerr << std::flush;
-        std::cout << std::flush << out.str() << std::flush;
-    }
-    else
-    {
-        std::cout << std::flush;
-        std::cerr << std::flush << out.str() << std::flush;
+        m_pattern.format(line, record);
+        line += '\n';
+        m_output.write(stream, level);
+        return;
     }
+
+    if (color)
+        line += levelColor(level);
+
+    line += '\n';
+    m_pattern.format(line, record);
+    line += "  "; // Some spacing
+
+    if (color)
+        line += RESET_COLOR;
+
+    m_output.write(stream, level);
 }
 
 void SimpleConsoleLogger::exception(const LogException &exception)
@@ -110,64 +123,96 @@ void SimpleConsoleLogger::exception(const LogException &exception)
     log(error, LogLevel::FATAL);
 }
 
-void ConsoleLogger::log(const std::string &message, const LogLevel level)
+void SimpleConsoleLogger::flush()
 {
-    if (level < m_minLogLevel or level > m_maxLogLevel)
-        return;
-
-    if (m_repeatedLevel == level and m_repeatedMessage == message)
-    {
-        // Repeated message
-        m_repeatCount++;
-
-        std::cout << "\r"; // This should work
+    std::lock_guard lock(m_mutex);
+    m_output.flush();
+}
 
-        if (m_fullColor)
-            std::cout << LogLevelColors[level];
+void SimpleConsoleLogger::poll()
+{
+    std::lock_guard lock(m_mutex);
+    m_output.poll();
+}
 
-        std::cout << "[" << getTime() << " " << (m_color and !m_fullColor ? LogLevelColors[level] : "")
-                  << formatStringFromLeft(LogLevelNames[level], MAX_LOG_LEVEL_NAME_LENGTH);
-        std::cout << " (Rep: " << m_repeatCount << ")" << (m_color and !m_fullColor ? RESET_COLOR : "") << "]: ";
-        std::cout << m_repeatedMessage;
+void SimpleConsoleLogger::setPattern(const PatternLayout &pattern)
+{
+    std::lock_guard lock(m_mutex);
+    m_pattern = pattern;
+}
 
-        if (m_fullColor)
-            std::cout << RESET_COLOR;
+PatternLayout SimpleConsoleLogger::getPattern()
+{
+    std::lock_guard lock(m_mutex);
+    return m_pattern;
+}
 
-        std::cout << std::flush;
+void SimpleConsoleLogger::setFlushPolicy(const FlushPolicy &policy)
+{
+    std::lock_guard lock(m_mutex);
+    m_output.setFlushPolicy(policy);
+}
 
-        return;
-    }
+FlushPolicy SimpleConsoleLogger::getFlushPolicy()
+{
+    std::lock_guard lock(m_mutex);
+    return m_output.getFlushPolicy();
+}
 
-    m_repeatCount = 1;
-    m_repeatedMessage = message;
-    m_repeatedLevel = level;
+void ConsoleLogger::log(const std::string &message, const LogLevel level)
+{
+    logRecord(makeRecord(level, message));
+}
 
-    std::stringstream out;
+void ConsoleLogger::logRecord(const LogRecord &record)
+{
+    const LogLevel level = record.level;
 
-    if (m_fullColor)
-        out << LogLevelColors[level];
+    if (level < m_minLogLevel or level > m_maxLogLevel)
+        return;
 
-    out << std::endl;
-    out << "[" << getTime() << " " << (m_color and !m_fullColor ? LogLevelColors[level] : "");
-    out << formatStringFromLeft(LogLevelNames[level], MAX_LOG_LEVEL_NAME_LENGTH);
-    out << (m_color and !m_fullColor ? RESET_COLOR : "") << "]: ";
+    const ConsoleStream stream = consoleStream(level);
+    const bool terminal = !m_detectTerminal or isConsoleTerminal(stream);
 
-    out << message;
-    out << "  "; // Some spacing
+    /* Compare hashes instead of keeping a copy of the last message, the level is part of the hash */
+    const uint64_t hash = terminal ? hashRecordContent(record) : 0;
 
-    if (m_fullColor)
-        out << RESET_COLOR;
+    std::lock_guard lock(m_mutex);
 
-    if (level < LogLevel::ERROR)
+    // Repeated messages rewrite the previous line with their count, which only works on a terminal
+    const bool repeated = terminal and m_repeatCount != 0 and m_repeatedHash == hash;
+    if (repeated)
     {
-        std::cerr << std::flush;
-        std::cout << std::flush << out.str() << std::flush;
+        m_repeatCount++;
     }
     else
     {
-        std::cout << std::flush;
-        std::cerr << std::flush << out.str() << std::flush;
+        m_repeatCount = 1;
+        m_repeatedHash = hash;
+    }
+
+    std::string &line = m_output.nextLine();
+
+    if (!terminal)
+    {
+        m_pattern.format(line, record);
+        line += '\n';
+        m_output.write(stream, level);
+        return;
     }
+
+    if (m_fullColor)
+        line += levelColor(level);
+
+    line += repeated ? '\r' : '\n';
+    m_pattern.format(line, record, {m_color and !m_fullColor, repeated ? m_repeatCount : 0});
+    if (!repeated)
+        line += "  "; // Some spacing
+
+    if (m_fullColor)
+        line += RESET_COLOR;
+
+    m_output.write(stream, level);
 }
 
 void ConsoleLogger::exception(const LogException &exception)
@@ -178,6 +223,18 @@ void ConsoleLogger::exception(const LogException &exception)
     log(error, LogLevel::FATAL);
 }
 
+void ConsoleLogger::flush()
+{
+    std::lock_guard lock(m_mutex);
+    m_output.flush();
+}
+
+void ConsoleLogger::poll()
+{
+    std::lock_guard lock(m_mutex);
+    m_output.poll();
+}
+
 FileLogger::FileLogger(const std::string &filename)
 {
     openFile(filename);
@@ -190,6 +247,8 @@ FileLogger::FileLogger(const std::string &filename)
 
 FileLogger::FileLogger(const std::string &filename, const LogFileMode mode) { openFile(filename, mode); }
 
+FileLogger::FileLogger(const std::ios::openmode openMode) : m_openMode(openMode) {}
+
 FileLogger::~FileLogger()
 {
     if (m_file.is_open())
@@ -200,35 +259,410 @@ void FileLogger::openFile(const ::std::string &filename) { openFile(filename, Lo
 
 void FileLogger::openFile(const std::string &filename, const LogFileMode mode)
 {
+    std::lock_guard lock(m_mutex);
+
+    if (m_file.is_open())
+    {
+        writeBuffer();
+        closeIndex();
+        m_file.close();
+    }
+
+    /* Records are collected in m_buffer, so every write is a single system call */
+    m_file.rdbuf()->pubsetbuf(nullptr, 0);
+
     if (mode == LogFileMode::OVERWRITE)
     {
-        m_file.open(filename, std::ios::out | std::ios::trunc);
+        m_file.open(filename, m_openMode | std::ios::out | std::ios::trunc);
     }
     else
     {
-        m_file.open(filename, std::ios::out | std::ios::app);
+        m_file.open(filename, m_openMode | std::ios::out | std::ios::app);
     }
 
     if (!m_file.is_open())
     {
         throw LogException("Could not open log file: " + filename);
     }
+
+    std::error_code error;
+    m_filename = filename;
+    m_fileSize = mode == LogFileMode::OVERWRITE ? 0 : std::filesystem::file_size(m_filename, error);
+    if (error)
+        m_fileSize = 0;
+    m_failedRotationSize = 0;
+    m_reopenPending = false;
+
+    if (m_rotationPolicy.interval != RotationInterval::NONE)
+        scheduleNextRotation(std::chrono::system_clock::now());
+
+    beginFile(m_buffer);
+    writeBuffer();
+
+    if (m_indexPolicy.enabled)
+        openIndex();
 }
 
 void FileLogger::closeFile()
 {
+    std::lock_guard lock(m_mutex);
+
     if (m_file.is_open())
+    {
+        writeBuffer();
+        closeIndex();
         m_file.close();
+    }
+
+    m_reopenPending = false;
 }
 
 void FileLogger::log(const std::string &message, const LogLevel level)
 {
-    if (level < m_minLogLevel or level > m_maxLogLevel)
+    logRecord(makeRecord(level, message));
+}
+
+void FileLogger::logRecord(const LogRecord &record)
+{
+    if (record.level < m_minLogLevel or record.level > m_maxLogLevel)
+        return;
+
+    std::lock_guard lock(m_mutex);
+
+    // Rough size of the record, only used to decide when to write or rotate
+    const std::size_t length = MAX_TIMESTAMP_LENGTH + MAX_LOG_LEVEL_NAME_LENGTH + record.message.size() +
+                               record.arguments.size() + 6;
+
+    /* Rotate before formatting, so everything in the buffer belongs to the file it's written to */
+    if (record.timestamp >= m_nextRotation or
+        (m_rotationPolicy.maxBytes != 0 and m_fileSize + m_buffer.size() != 0 and
+         m_fileSize + m_buffer.size() + length > m_failedRotationSize + m_rotationPolicy.maxBytes))
+    {
+        writeBuffer();
+        rotate();
+    }
+
+    if (!m_buffer.empty() and m_buffer.size() + length > m_flushPolicy.bufferSize)
+        writeBuffer();
+
+    if (m_buffer.empty())
+        m_bufferedSince = std::chrono::steady_clock::now();
+
+    const uint64_t offset = m_fileSize + m_buffer.size();
+    formatRecord(m_buffer, record);
+
+    if (m_indexFile.is_open())
+    {
+        m_indexEntry.add(offset, record);
+        m_indexEntry.length = m_fileSize + m_buffer.size() - m_indexEntry.offset;
+
+        if ((m_indexPolicy.records != 0 and m_indexEntry.records >= m_indexPolicy.records) or
+            (m_indexPolicy.bytes != 0 and m_indexEntry.length >= m_indexPolicy.bytes))
+            finishIndexEntry();
+    }
+
+    if (m_flushPolicy.mode == FlushMode::ALWAYS or record.level >= m_flushPolicy.flushLevel or
+        (m_flushPolicy.flushBytes != 0 and m_buffer.size() >= m_flushPolicy.flushBytes) or
+        (m_flushPolicy.flushInterval.count() != 0 and
+         std::chrono::steady_clock::now() - m_bufferedSince >= m_flushPolicy.flushInterval))
+    {
+        writeBuffer();
+    }
+}
+
+void FileLogger::formatRecord(std::string &out, const LogRecord &record) { m_pattern.format(out, record); }
+
+void FileLogger::beginFile(std::string &) {}
+
+void FileLogger::flush()
+{
+    std::lock_guard lock(m_mutex);
+    writeBuffer();
+}
+
+void FileLogger::poll()
+{
+    std::lock_guard lock(m_mutex);
+
+    if (!m_buffer.empty() and m_flushPolicy.flushInterval.count() != 0 and
+        std::chrono::steady_clock::now() - m_bufferedSince >= m_flushPolicy.flushInterval)
+    {
+        writeBuffer();
+    }
+}
+
+void FileLogger::setFlushPolicy(const FlushPolicy &policy)
+{
+    std::lock_guard lock(m_mutex);
+
+    writeBuffer();
+    m_flushPolicy = policy;
+    m_buffer.reserve(policy.mode == FlushMode::BUFFERED ? policy.bufferSize : 0);
+}
+
+FlushPolicy FileLogger::getFlushPolicy()
+{
+    std::lock_guard lock(m_mutex);
+    return m_flushPolicy;
+}
+
+void FileLogger::setRotationPolicy(const RotationPolicy &policy)
+{
+    if (policy.compress and !RotationWorker::compressionAvailable())
+        throw LogException("Compressing rotated log files requires SimpleLogger to be built with zlib");
+
+    std::lock_guard lock(m_mutex);
+
+    m_rotationPolicy = policy;
+    m_rotationWorker = RotationWorker::instance();
+
+    if (policy.interval != RotationInterval::NONE)
+        scheduleNextRotation(std::chrono::system_clock::now());
+    else
+        m_nextRotation = std::chrono::system_clock::time_point::max();
+}
+
+RotationPolicy FileLogger::getRotationPolicy()
+{
+    std::lock_guard lock(m_mutex);
+    return m_rotationPolicy;
+}
+
+void FileLogger::setPattern(const PatternLayout &pattern)
+{
+    std::lock_guard lock(m_mutex);
+    m_pattern = pattern;
+}
+
+PatternLayout FileLogger::getPattern()
+{
+    std::lock_guard lock(m_mutex);
+    return m_pattern;
+}
+
+void FileLogger::writeBuffer()
+{
+    if (!m_buffer.empty() and m_file.is_open())
+    {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_fileSize += m_buffer.size();
+
+        metrics().addBytes(m_buffer.size());
+        metrics().addFlush();
+    }
+
+    m_buffer.clear();
+
+    // Index entries are written after the records they cover, so they never point past the end of the file
+    if (!m_indexBuffer.empty())
+    {
+        if (m_indexFile.is_open())
+            m_indexFile.write(m_indexBuffer.data(), static_cast<std::streamsize>(m_indexBuffer.size()));
+
+        m_indexBuffer.clear();
+    }
+}
+
+void FileLogger::openIndex()
+{
+    const auto path = logIndexPath(m_filename);
+
+    // Add to the existing index only if it belongs to this file, a cut off last entry is dropped first
+    bool append = false;
+    if (m_fileSize != 0)
+    {
+        try
+        {
+            const LogIndexReader reader(path);
+            const auto &entries = reader.entries();
+            append = entries.empty() or entries.back().offset + entries.back().length <= m_fileSize;
+
+            std::error_code error;
+            if (append)
+                std::filesystem::resize_file(path, LOG_INDEX_HEADER_SIZE + entries.size() * LOG_INDEX_ENTRY_SIZE,
+                                             error);
+        }
+        catch (const LogException &)
+        {
+            append = false;
+        }
+    }
+
+    m_indexFile.close();
+    m_indexFile.rdbuf()->pubsetbuf(nullptr, 0);
+    m_indexFile.open(path, std::ios::binary | std::ios::out | (append ? std::ios::app : std::ios::trunc));
+
+    if (!m_indexFile.is_open())
+        throw LogException("Could not open log index: " + path.string());
+
+    if (!append)
+    {
+        std::string header;
+        appendIndexHeader(header);
+        m_indexFile.write(header.data(), static_cast<std::streamsize>(header.size()));
+    }
+
+    m_indexEntry = {};
+}
+
+void FileLogger::closeIndex()
+{
+    if (!m_indexFile.is_open())
         return;
 
-    m_file << "[" << getTime() << " " << formatStringFromLeft(LogLevelNames[level], MAX_LOG_LEVEL_NAME_LENGTH)
-           << "]: " << message << std::endl;
-    m_file.flush();
+    finishIndexEntry();
+    writeBuffer();
+    m_indexFile.close();
+}
+
+void FileLogger::finishIndexEntry()
+{
+    if (m_indexEntry.records == 0)
+        return;
+
+    appendIndexEntry(m_indexBuffer, m_indexEntry);
+    m_indexEntry = {};
+}
+
+void FileLogger::setIndexPolicy(const IndexPolicy &policy)
+{
+    std::lock_guard lock(m_mutex);
+
+    if (!policy.enabled)
+    {
+        closeIndex();
+    }
+    else if (m_file.is_open() and !m_indexFile.is_open())
+    {
+        writeBuffer();
+        openIndex();
+    }
+
+    m_indexPolicy = policy;
+}
+
+IndexPolicy FileLogger::getIndexPolicy()
+{
+    std::lock_guard lock(m_mutex);
+    return m_indexPolicy;
+}
+
+void FileLogger::rotate()
+{
+    if (!m_file.is_open() and !m_reopenPending)
+        return;
+
+    const auto now = std::chrono::system_clock::now();
+    const std::tm calendar = toCalendarTime(std::chrono::system_clock::to_time_t(now));
+
+    char suffix[32];
+    std::strftime(suffix, sizeof(suffix), ".%Y%m%d-%H%M%S", &calendar);
+
+    const bool indexed = m_indexFile.is_open() or (m_reopenPending and m_indexPolicy.enabled);
+    closeIndex();
+
+    /*
+     * Only the rename that frees the file's name and the open happen here. The rotated file gets a temporary name
+     * no other file has, the rotation worker picks its final name, compresses it and removes old files.
+     */
+    std::filesystem::path rotated;
+    std::error_code error;
+    if (m_file.is_open())
+    {
+        m_file.close();
+
+        rotated = m_filename;
+        rotated += ".rotating" + std::string(suffix) + "." + std::to_string(m_rotations++);
+        std::filesystem::rename(m_filename, rotated, error);
+
+        if (error)
+        {
+            // Keep appending to the file as it is and try again at the next boundary
+            reportLoggerError("Could not rotate " + m_filename.string() + ": " + error.message());
+            rotated.clear();
+            m_failedRotationSize = m_fileSize;
+        }
+        else
+        {
+            m_failedRotationSize = 0;
+
+            std::error_code indexError;
+            if (indexed)
+                std::filesystem::rename(logIndexPath(m_filename), logIndexPath(rotated), indexError);
+            if (indexError)
+                std::filesystem::remove(logIndexPath(m_filename), indexError);
+        }
+    }
+
+    m_file.rdbuf()->pubsetbuf(nullptr, 0);
+    m_file.open(m_filename, m_openMode | std::ios::out | (rotated.empty() ? std::ios::app : std::ios::trunc));
+
+    m_fileSize = 0;
+    if (rotated.empty())
+    {
+        m_fileSize = std::filesystem::file_size(m_filename, error);
+        if (error)
+            m_fileSize = 0;
+    }
+
+    if (!rotated.empty() and m_rotationWorker)
+        m_rotationWorker->schedule({rotated, m_filename, suffix, m_rotationPolicy.maxFiles, m_rotationPolicy.compress});
+
+    if (m_rotationPolicy.interval != RotationInterval::NONE)
+        scheduleNextRotation(now);
+    else
+        m_nextRotation = std::chrono::system_clock::time_point::max();
+
+    const bool reportReopen = !m_reopenPending;
+    m_reopenPending = !m_file.is_open();
+    if (m_reopenPending)
+    {
+        // Records are dropped until the file opens again, retried at the next boundary or after a second
+        if (reportReopen)
+            reportLoggerError("Could not open " + m_filename.string() + " after rotating it, records are dropped");
+
+        m_nextRotation = std::min(m_nextRotation, now + std::chrono::seconds(1));
+        return;
+    }
+
+    // A file that was appended to already starts with what beginFile writes
+    if (!rotated.empty() or m_fileSize == 0)
+    {
+        beginFile(m_buffer);
+        writeBuffer();
+    }
+
+    if (indexed)
+    {
+        try
+        {
+            openIndex();
+        }
+        catch (const LogException &)
+        {
+            // Like the log file itself, a failed reopen leaves the rest of the records unindexed instead of throwing
+        }
+    }
+}
+
+void FileLogger::scheduleNextRotation(const std::chrono::system_clock::time_point now)
+{
+    std::tm calendar = toCalendarTime(std::chrono::system_clock::to_time_t(now));
+    calendar.tm_min = 0;
+    calendar.tm_sec = 0;
+
+    if (m_rotationPolicy.interval == RotationInterval::DAILY)
+    {
+        calendar.tm_hour = 0;
+        calendar.tm_mday++;
+    }
+    else
+    {
+        calendar.tm_hour++;
+    }
+
+    // The overflowed fields are normalized on the way back
+    m_nextRotation = std::chrono::system_clock::from_time_t(fromCalendarTime(calendar, getTimeZone()));
 }
 
 void FileLogger::exception(const LogException &exception)
@@ -0,0 +1,153 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "loggermetrics.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <typeinfo>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define SL_HAS_CXXABI
+#endif
+
+#include "loggerloc.hpp"
+#include "structuredlog.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+std::atomic<uint32_t> s_nextShard = 0;
+
+/* Largest value that falls into the bucket */
+uint64_t bucketUpperBound(const std::size_t bucket)
+{
+    constexpr std::size_t subBuckets = 1u << detail::LATENCY_SUB_BITS;
+    if (bucket < subBuckets)
+        return bucket;
+
+    const std::size_t shift = (bucket >> detail::LATENCY_SUB_BITS) - 1;
+    const uint64_t lower = static_cast<uint64_t>(subBuckets + (bucket & (subBuckets - 1))) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+uint64_t percentile(const std::array<uint64_t, detail::LATENCY_BUCKETS> &buckets, const uint64_t samples,
+                    const double fraction)
+{
+    const auto target = static_cast<uint64_t>(fraction * static_cast<double>(samples - 1)) + 1;
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+            return bucketUpperBound(i);
+    }
+
+    return bucketUpperBound(buckets.size() - 1);
+}
+
+} // namespace
+
+uint32_t detail::nextMetricsShard()
+{
+    return s_nextShard.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(METRICS_SHARDS);
+}
+
+SinkMetricsSnapshot SinkMetrics::snapshot() const
+{
+    SinkMetricsSnapshot snapshot;
+    std::array<uint64_t, detail::LATENCY_BUCKETS> buckets{};
+
+    for (const auto &shard: m_shards)
+    {
+        snapshot.accepted += shard.accepted.load(std::memory_order_relaxed);
+        snapshot.filtered += shard.filtered.load(std::memory_order_relaxed);
+        snapshot.bytes += shard.bytes.load(std::memory_order_relaxed);
+        snapshot.flushes += shard.flushes.load(std::memory_order_relaxed);
+        snapshot.dropped += shard.dropped.load(std::memory_order_relaxed);
+        snapshot.latency.totalNs += shard.latencyTotal.load(std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < buckets.size(); i++)
+            buckets[i] += shard.latency[i].load(std::memory_order_relaxed);
+    }
+
+    for (std::size_t i = 0; i < buckets.size(); i++)
+    {
+        snapshot.latency.samples += buckets[i];
+        if (buckets[i] != 0)
+            snapshot.latency.maxNs = bucketUpperBound(i);
+    }
+
+    if (snapshot.latency.samples != 0)
+    {
+        snapshot.latency.p50Ns = percentile(buckets, snapshot.latency.samples, 0.50);
+        snapshot.latency.p99Ns = percentile(buckets, snapshot.latency.samples, 0.99);
+        snapshot.latency.p999Ns = percentile(buckets, snapshot.latency.samples, 0.999);
+    }
+
+    return snapshot;
+}
+
+void LoggerMetrics::fill(MetricsSnapshot &snapshot) const
+{
+    for (const auto &shard: m_shards)
+    {
+        for (std::size_t level = 0; level < snapshot.records.size(); level++)
+            snapshot.records[level] += shard.records[level].load(std::memory_order_relaxed);
+
+        snapshot.flushes += shard.flushes.load(std::memory_order_relaxed);
+        snapshot.queueFullWaits += shard.queueFullWaits.load(std::memory_order_relaxed);
+        snapshot.dropped += shard.dropped.load(std::memory_order_relaxed);
+    }
+}
+
+std::string loggerName(const LoggerLoc &loggerLoc)
+{
+    const char *mangled = typeid(loggerLoc).name();
+    std::string name = mangled;
+
+#ifdef SL_HAS_CXXABI
+    int status = 0;
+    if (char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status); demangled != nullptr)
+    {
+        name = demangled;
+        std::free(demangled);
+    }
+#endif // SL_HAS_CXXABI
+
+    // "slog::FileLogger" -> "FileLogger", keep the namespaces of other loggers
+    if (name.starts_with("slog::"))
+        name.erase(0, 6);
+
+    return name;
+}
+
+void logMetrics(LoggerLoc &loggerLoc, const MetricsSnapshot &snapshot)
+{
+    LogRecord record;
+    record.level = LogLevel::INFO;
+    record.timestamp = std::chrono::system_clock::now();
+
+    record.message = "Logger metrics";
+    encodeFields(record.fields, "records_debug", snapshot.records[0], "records_info", snapshot.records[1],
+                 "records_warning", snapshot.records[2], "records_error", snapshot.records[3], "records_fatal",
+                 snapshot.records[4], "flushes", snapshot.flushes, "queue_depth", snapshot.queueDepth,
+                 "queue_full_waits", snapshot.queueFullWaits, "dropped", snapshot.dropped);
+    loggerLoc.logRecord(record);
+
+    for (const auto &sink: snapshot.sinks)
+    {
+        record.message = "Sink metrics";
+        record.fields.clear();
+        encodeFields(record.fields, "sink", sink.name, "accepted", sink.accepted, "filtered", sink.filtered, "bytes",
+                     sink.bytes, "flushes", sink.flushes, "dropped", sink.dropped, "timed", sink.latency.samples,
+                     "p50_ns", sink.latency.p50Ns, "p99_ns", sink.latency.p99Ns, "p999_ns", sink.latency.p999Ns,
+                     "max_ns", sink.latency.maxNs);
+        loggerLoc.logRecord(record);
+    }
+}
+
+} // namespace slog
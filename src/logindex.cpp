@@ -0,0 +1,151 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "logindex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "logexception.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+template<typename T>
+void appendValue(std::string &out, const T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template<typename T>
+T readValue(const char *&data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+}
+
+void addRange(std::vector<LogIndexRange> &ranges, const uint64_t offset, const uint64_t length)
+{
+    if (length == 0)
+        return;
+
+    if (!ranges.empty() and ranges.back().offset + ranges.back().length == offset)
+        ranges.back().length += length;
+    else
+        ranges.push_back({offset, length});
+}
+
+} // namespace
+
+void LogIndexEntry::add(const uint64_t recordOffset, const LogRecord &record)
+{
+    const int64_t time =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch()).count();
+
+    if (records == 0)
+    {
+        offset = recordOffset;
+        earliestNs = time;
+        latestNs = time;
+    }
+
+    earliestNs = std::min(earliestNs, time);
+    latestNs = std::max(latestNs, time);
+    levels |= levelBit(record.level);
+    records++;
+}
+
+std::filesystem::path logIndexPath(const std::filesystem::path &logFile)
+{
+    auto path = logFile;
+    path += LOG_INDEX_SUFFIX;
+    return path;
+}
+
+void appendIndexHeader(std::string &out)
+{
+    out.append(LOG_INDEX_MAGIC.data(), LOG_INDEX_MAGIC.size());
+    appendValue(out, LOG_INDEX_BYTE_ORDER);
+}
+
+void appendIndexEntry(std::string &out, const LogIndexEntry &entry)
+{
+    appendValue(out, entry.offset);
+    appendValue(out, entry.length);
+    appendValue(out, entry.earliestNs);
+    appendValue(out, entry.latestNs);
+    appendValue(out, entry.records);
+    appendValue(out, entry.levels);
+    out.append(3, '\0');
+}
+
+LogIndexReader::LogIndexReader(const std::filesystem::path &indexFile)
+{
+    std::ifstream file(indexFile, std::ios::binary);
+    if (!file.is_open())
+        throw LogException("Could not open log index: " + indexFile.string());
+
+    const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    uint32_t byteOrder = 0;
+    if (contents.size() >= LOG_INDEX_HEADER_SIZE)
+        std::memcpy(&byteOrder, contents.data() + LOG_INDEX_MAGIC.size(), sizeof(byteOrder));
+
+    if (contents.size() < LOG_INDEX_HEADER_SIZE or
+        !std::equal(LOG_INDEX_MAGIC.begin(), LOG_INDEX_MAGIC.end(), contents.begin()) or
+        byteOrder != LOG_INDEX_BYTE_ORDER)
+    {
+        throw LogException("Not a log index (or written with a different byte order): " + indexFile.string());
+    }
+
+    const std::size_t count = (contents.size() - LOG_INDEX_HEADER_SIZE) / LOG_INDEX_ENTRY_SIZE;
+    m_entries.reserve(count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const char *data = contents.data() + LOG_INDEX_HEADER_SIZE + i * LOG_INDEX_ENTRY_SIZE;
+
+        LogIndexEntry entry;
+        entry.offset = readValue<uint64_t>(data);
+        entry.length = readValue<uint64_t>(data);
+        entry.earliestNs = readValue<int64_t>(data);
+        entry.latestNs = readValue<int64_t>(data);
+        entry.records = readValue<uint32_t>(data);
+        entry.levels = readValue<uint8_t>(data);
+        m_entries.push_back(entry);
+    }
+
+    std::ranges::sort(m_entries, {}, &LogIndexEntry::offset);
+}
+
+std::vector<LogIndexRange> LogIndexReader::find(const int64_t fromNs, const int64_t toNs, const uint8_t levels,
+                                                const uint64_t logSize) const
+{
+    std::vector<LogIndexRange> ranges;
+    uint64_t covered = 0;
+
+    for (const auto &entry: m_entries)
+    {
+        // Entries past the end belong to an earlier file of the same name
+        if (entry.offset < covered or entry.offset + entry.length > logSize)
+            continue;
+
+        addRange(ranges, covered, entry.offset - covered);
+        if ((entry.levels & levels) != 0 and entry.latestNs >= fromNs and entry.earliestNs < toNs)
+            addRange(ranges, entry.offset, entry.length);
+
+        covered = entry.offset + entry.length;
+    }
+
+    addRange(ranges, covered, logSize - std::min(covered, logSize));
+    return ranges;
+}
+
+} // namespace slog
@@ -0,0 +1,233 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "logpattern.hpp"
+
+#include <charconv>
+#include <limits>
+
+#include "logexception.hpp"
+#include "loggerloc.hpp"
+#include "structuredlog.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+/* Calendar parts of a {time:...} specification for one second, so strftime runs once a second per specification */
+struct TimeCache
+{
+    std::array<char, MAX_TIME_SPEC_LENGTH> spec{};
+    std::size_t specLength = 0;
+    int64_t second = std::numeric_limits<int64_t>::min();
+    uint32_t generation = 0;
+
+    /* The specification formatted before and after its %f */
+    std::array<char, 128> before{};
+    std::size_t beforeLength = 0;
+    std::array<char, 128> after{};
+    std::size_t afterLength = 0;
+};
+
+/* A few specifications per thread are enough for the loggers a program has, they're replaced round robin */
+thread_local std::array<TimeCache, 4> t_timeCaches;
+thread_local std::size_t t_nextTimeCache = 0;
+
+template<typename Number>
+void appendNumber(std::string &out, const Number value)
+{
+    std::array<char, 24> digits{};
+    const char *end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    out.append(digits.data(), static_cast<std::size_t>(end - digits.data()));
+}
+
+std::size_t formatCalendar(std::array<char, 128> &out, const std::string_view spec, const std::tm &calendar)
+{
+    if (spec.empty())
+        return 0;
+
+    // strftime wants a terminated format
+    std::array<char, MAX_TIME_SPEC_LENGTH + 1> format{};
+    std::copy(spec.begin(), spec.end(), format.begin());
+
+    return std::strftime(out.data(), out.size(), format.data(), &calendar);
+}
+
+TimeCache &timeCache(const std::string_view spec, const int64_t second)
+{
+    const uint32_t generation = getTimeSettingsGeneration();
+
+    for (auto &cache: t_timeCaches)
+    {
+        if (std::string_view(cache.spec.data(), cache.specLength) == spec)
+        {
+            if (cache.second != second or cache.generation != generation)
+            {
+                const std::tm calendar = toCalendarTime(static_cast<std::time_t>(second));
+                const auto fraction = spec.find("%f");
+                cache.beforeLength = formatCalendar(cache.before, spec.substr(0, fraction), calendar);
+                cache.afterLength = fraction == std::string_view::npos
+                                            ? 0
+                                            : formatCalendar(cache.after, spec.substr(fraction + 2), calendar);
+                cache.second = second;
+                cache.generation = generation;
+            }
+
+            return cache;
+        }
+    }
+
+    TimeCache &cache = t_timeCaches[t_nextTimeCache++ % t_timeCaches.size()];
+    std::copy(spec.begin(), spec.end(), cache.spec.begin());
+    cache.specLength = spec.size();
+    cache.second = std::numeric_limits<int64_t>::min();
+
+    return timeCache(spec, second);
+}
+
+void appendTime(std::string &out, const std::string_view spec, const LogRecord &record)
+{
+    if (spec.empty())
+    {
+        out += (record.time.empty() ? formatTime(record.timestamp) : record.time).view();
+        return;
+    }
+
+    const int64_t nanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch()).count();
+    int64_t second = nanoseconds / 1'000'000'000;
+    if (nanoseconds % 1'000'000'000 < 0)
+        second--;
+
+    const TimeCache &cache = timeCache(spec, second);
+    out.append(cache.before.data(), cache.beforeLength);
+
+    if (spec.find("%f") == std::string_view::npos)
+        return;
+
+    const int digits = static_cast<int>(getTimePrecision());
+    auto fraction = static_cast<uint64_t>(nanoseconds - second * 1'000'000'000);
+    for (int i = digits; i < 9; i++)
+        fraction /= 10;
+
+    std::array<char, 9> fractionDigits{};
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        fractionDigits[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    out.append(fractionDigits.data(), static_cast<std::size_t>(digits));
+
+    out.append(cache.after.data(), cache.afterLength);
+}
+
+} // namespace
+
+void detail::invalidLogPattern(const char *error) { throw LogException(error); }
+
+void detail::appendToken(std::string &out, const PatternSegment &segment, const LogRecord &record,
+                         const PatternContext &context)
+{
+    switch (segment.token)
+    {
+        case PatternToken::TEXT:
+            out += segment.text;
+            break;
+        case PatternToken::TIME:
+            appendTime(out, segment.text, record);
+            break;
+        case PatternToken::LEVEL:
+            out += levelName(record.level);
+            break;
+        case PatternToken::MESSAGE:
+            out += record.message;
+            break;
+        case PatternToken::FIELDS:
+            formatLogfmtFields(out, record.fields);
+            break;
+        case PatternToken::CATEGORY:
+            out += record.category;
+            break;
+        case PatternToken::THREAD:
+            formatThread(out, record);
+            break;
+        case PatternToken::THREAD_ID:
+            if (record.threadId != 0)
+                appendNumber(out, record.threadId);
+            break;
+        case PatternToken::THREAD_NAME:
+            out += record.threadName.view();
+            break;
+        case PatternToken::FILE:
+        {
+            std::string_view file = record.location.file_name();
+            if (const auto slash = file.find_last_of("/\\"); slash != std::string_view::npos)
+                file.remove_prefix(slash + 1);
+            out += file;
+            break;
+        }
+        case PatternToken::PATH:
+            out += record.location.file_name();
+            break;
+        case PatternToken::LINE:
+            if (record.location.line() != 0)
+                appendNumber(out, record.location.line());
+            break;
+        case PatternToken::FUNCTION:
+            out += record.location.function_name();
+            break;
+        case PatternToken::COLOR:
+            if (context.levelColor)
+                out += levelColor(record.level);
+            break;
+        case PatternToken::RESET:
+            if (context.levelColor)
+                out += RESET_COLOR;
+            break;
+        case PatternToken::REPEAT:
+            if (context.repeats != 0)
+            {
+                out += " (Rep: ";
+                appendNumber(out, context.repeats);
+                out += ')';
+            }
+            break;
+    }
+}
+
+void detail::alignToken(std::string &out, const std::size_t start, const PatternAlign align, const std::size_t width)
+{
+    const std::size_t length = out.size() - start;
+    if (length >= width)
+        return;
+
+    const std::size_t padding = width - length;
+    switch (align)
+    {
+        case PatternAlign::LEFT:
+            out.append(padding, ' ');
+            break;
+        case PatternAlign::RIGHT:
+            out.insert(start, padding, ' ');
+            break;
+        case PatternAlign::CENTER:
+            out.insert(start, padding / 2, ' ');
+            out.append(padding - padding / 2, ' ');
+            break;
+    }
+}
+
+PatternLayout::PatternLayout(const std::string_view pattern) :
+    m_text(std::make_shared<const std::string>(pattern))
+{
+    m_source = *m_text;
+
+    std::size_t count = 0;
+    if (const char *error = detail::parsePattern(m_source, nullptr, count))
+        throw LogException("Invalid log pattern \"" + *m_text + "\": " + error);
+
+    m_segments.resize(count);
+    detail::parsePattern(m_source, m_segments.data(), count);
+}
+
+} // namespace slog
@@ -0,0 +1,253 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "loggerloc.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace slog
+{
+
+namespace
+{
+
+/* Continues after the highest existing "<file>.n", so the segments of an earlier run (and its crash data) are kept */
+uint32_t firstSegmentIndex(const std::string &filename)
+{
+    const std::filesystem::path path(filename);
+    const auto directory = path.has_parent_path() ? path.parent_path() : ".";
+    const std::string prefix = path.filename().string() + ".";
+
+    std::optional<uint32_t> highest;
+    std::error_code error;
+    for (const auto &entry: std::filesystem::directory_iterator(directory, error))
+    {
+        const std::string name = entry.path().filename().string();
+        if (!name.starts_with(prefix))
+            continue;
+
+        uint32_t index = 0;
+        const char *begin = name.data() + prefix.size();
+        const char *end = name.data() + name.size();
+        const auto [last, errc] = std::from_chars(begin, end, index);
+        if (errc == std::errc() and last == end and begin != end)
+            highest = std::max(highest.value_or(0), index);
+    }
+
+    return highest ? *highest + 1 : 0;
+}
+
+} // namespace
+
+MmapFileLogger::MmapFileLogger(const std::string &filename, const std::size_t segmentSize)
+{
+    openFile(filename, segmentSize);
+}
+
+MmapFileLogger::~MmapFileLogger() { closeFile(); }
+
+void MmapFileLogger::openFile(const std::string &filename, const std::size_t segmentSize)
+{
+    std::lock_guard lock(m_mutex);
+
+    closeSegment();
+
+    m_filename = filename;
+    m_segmentSize = std::max(segmentSize, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+    m_segmentIndex = firstSegmentIndex(filename);
+
+    openSegment();
+}
+
+void MmapFileLogger::closeFile()
+{
+    std::lock_guard lock(m_mutex);
+    closeSegment();
+}
+
+void MmapFileLogger::log(const std::string &message, const LogLevel level)
+{
+    logRecord(makeRecord(level, message));
+}
+
+void MmapFileLogger::exception(const LogException &exception)
+{
+    std::string error = "Uncaught Exception Occurred! ";
+    error += exception.what();
+
+    log(error, LogLevel::FATAL);
+}
+
+void MmapFileLogger::logRecord(const LogRecord &record)
+{
+    if (record.level < m_minLogLevel or record.level > m_maxLogLevel)
+        return;
+
+    std::lock_guard lock(m_mutex);
+
+    if (m_mapping == nullptr)
+        return;
+
+    m_line.clear();
+    m_pattern.format(m_line, record);
+
+    // Lines longer than a whole segment are cut off
+    const std::size_t length = std::min(m_line.size(), m_segmentSize);
+
+    if (m_offset + length > m_segmentSize)
+    {
+        closeSegment();
+        m_segmentIndex++;
+
+        // Logging must not throw, without a segment the logger stays disabled until openFile is called again
+        try
+        {
+            openSegment();
+        }
+        catch (const LogException &exception)
+        {
+            reportLoggerError(std::string(exception.what()) + ", records are dropped");
+            return;
+        }
+    }
+
+    std::memcpy(m_mapping + m_offset, m_line.data(), length);
+    m_offset += length;
+    metrics().addBytes(length);
+
+    if (m_syncInterval.count() != 0 and std::chrono::steady_clock::now() - m_lastSync >= m_syncInterval)
+        sync();
+}
+
+void MmapFileLogger::flush()
+{
+    std::lock_guard lock(m_mutex);
+    sync();
+}
+
+void MmapFileLogger::poll()
+{
+    std::lock_guard lock(m_mutex);
+
+    if (m_syncInterval.count() != 0 and std::chrono::steady_clock::now() - m_lastSync >= m_syncInterval)
+        sync();
+}
+
+void MmapFileLogger::setSyncInterval(const std::chrono::milliseconds interval)
+{
+    std::lock_guard lock(m_mutex);
+    m_syncInterval = interval;
+}
+
+void MmapFileLogger::setPattern(const PatternLayout &pattern)
+{
+    std::lock_guard lock(m_mutex);
+    m_pattern = pattern;
+}
+
+PatternLayout MmapFileLogger::getPattern()
+{
+    std::lock_guard lock(m_mutex);
+    return m_pattern;
+}
+
+uint32_t MmapFileLogger::getSegmentIndex()
+{
+    std::lock_guard lock(m_mutex);
+    return m_segmentIndex;
+}
+
+void MmapFileLogger::openSegment()
+{
+    std::string path;
+    while (true)
+    {
+        path = m_filename + "." + std::to_string(m_segmentIndex);
+
+        // Never truncated, a segment that already has data in it is skipped
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (m_fd < 0)
+            throw LogException("Could not open log file: " + path + " (" + std::strerror(errno) + ")");
+
+        struct stat status{};
+        if (fstat(m_fd, &status) == 0 and status.st_size == 0)
+            break;
+
+        ::close(m_fd);
+        m_fd = -1;
+        m_segmentIndex++;
+    }
+
+    // Reserve the blocks up front so writing into the mapping can't fail on a full disk later. Only a filesystem that
+    // can't preallocate gets a sparse file, any other failure (ENOSPC) would leave pages that SIGBUS when written
+    const auto size = static_cast<off_t>(m_segmentSize);
+    int result = posix_fallocate(m_fd, 0, size);
+    if (result == EOPNOTSUPP or result == EINVAL)
+        result = ftruncate(m_fd, size) == 0 ? 0 : errno;
+
+    if (result != 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        throw LogException("Could not allocate log segment: " + path + " (" + std::strerror(result) + ")");
+    }
+
+    void *mapping = mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        throw LogException("Could not map log segment: " + path + " (" + std::strerror(errno) + ")");
+    }
+
+    m_mapping = static_cast<char *>(mapping);
+    m_offset = 0;
+    m_syncedOffset = 0;
+    m_lastSync = std::chrono::steady_clock::now();
+}
+
+void MmapFileLogger::closeSegment()
+{
+    if (m_mapping != nullptr)
+    {
+        sync();
+        munmap(m_mapping, m_segmentSize);
+        m_mapping = nullptr;
+    }
+
+    if (m_fd >= 0)
+    {
+        // Drop the preallocated space that was never written, if this fails readers skip the zero padding
+        const int truncated = ftruncate(m_fd, static_cast<off_t>(m_offset));
+        static_cast<void>(truncated);
+
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void MmapFileLogger::sync()
+{
+    m_lastSync = std::chrono::steady_clock::now();
+
+    if (m_mapping == nullptr or m_offset == m_syncedOffset)
+        return;
+
+    // msync needs a page aligned start
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t start = m_syncedOffset / pageSize * pageSize;
+
+    msync(m_mapping + start, m_offset - start, MS_SYNC);
+    metrics().addFlush();
+    m_syncedOffset = m_offset;
+}
+
+} // namespace slog
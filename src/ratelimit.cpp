@@ -0,0 +1,60 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "ratelimit.hpp"
+
+#include <string>
+#include <string_view>
+
+#include "simplelogger.hpp"
+
+namespace slog
+{
+
+std::atomic<CallSiteLimiter *> CallSiteLimiter::s_head = nullptr;
+
+CallSiteLimiter::CallSiteLimiter(const RateLimit &limit, const LogLevel level, const std::source_location &location) :
+    m_limit(limit), m_level(level), m_location(location), m_lastSummary(now())
+{
+    m_next = s_head.load(std::memory_order_relaxed);
+    while (!s_head.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+void CallSiteLimiter::summarizeAll(const bool force)
+{
+    for (auto *limiter = s_head.load(std::memory_order_acquire); limiter != nullptr; limiter = limiter->m_next)
+    {
+        if (limiter->suppressed() != 0)
+            limiter->summarize(force);
+    }
+}
+
+void CallSiteLimiter::summarize(const bool force)
+{
+    const int64_t time = now();
+    int64_t last = m_lastSummary.load(std::memory_order_relaxed);
+
+    if (!force and time - last < std::chrono::nanoseconds(SUPPRESSED_SUMMARY_INTERVAL).count())
+        return;
+
+    // Whoever moves the summary time forward reports the count, everybody else keeps logging
+    if (!m_lastSummary.compare_exchange_strong(last, time, std::memory_order_relaxed))
+        return;
+
+    const uint64_t count = m_suppressed.exchange(0, std::memory_order_relaxed);
+    if (count == 0)
+        return;
+
+    std::string_view file = m_location.file_name();
+    if (const auto slash = file.find_last_of("/\\"); slash != std::string_view::npos)
+        file.remove_prefix(slash + 1);
+
+    std::string message = "Suppressed messages from ";
+    message += file;
+    message += ':';
+    message += std::to_string(m_location.line());
+
+    SimpleLogger::GlobalLogger()->logFields(m_level, m_location, message, "suppressed", count);
+}
+
+} // namespace slog
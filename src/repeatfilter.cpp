@@ -0,0 +1,183 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "repeatfilter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+namespace slog
+{
+
+namespace
+{
+
+void combine(uint64_t &hash, const uint64_t value)
+{
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+}
+
+uint64_t hashString(const std::string_view value) { return std::hash<std::string_view>{}(value); }
+
+} // namespace
+
+uint64_t hashRecordContent(const LogRecord &record)
+{
+    uint64_t hash = static_cast<uint64_t>(static_cast<int>(record.level) + 1);
+
+    if (!record.format.empty())
+    {
+        combine(hash, hashString(record.format));
+        combine(hash, hashString(record.arguments));
+    }
+    else
+    {
+        combine(hash, hashString(record.message));
+    }
+
+    combine(hash, hashString(record.fields));
+    return hash;
+}
+
+uint64_t hashRecord(const LogRecord &record)
+{
+    uint64_t hash = hashRecordContent(record);
+
+    // file_name() points at a string literal, comparing the pointer is enough to tell call sites apart
+    combine(hash, reinterpret_cast<uintptr_t>(record.location.file_name()));
+    combine(hash, (static_cast<uint64_t>(record.location.line()) << 32) | record.location.column());
+    return hash;
+}
+
+RepeatFilter::RepeatFilter(std::shared_ptr<LoggerLoc> logger, const std::size_t window,
+                           const std::chrono::milliseconds timeout) :
+    m_logger(std::move(logger)), m_timeout(timeout), m_window(std::max<std::size_t>(window, 1))
+{
+    m_minLogLevel = m_logger->getMinLogLevel();
+    m_maxLogLevel = m_logger->getMaxLogLevel();
+}
+
+void RepeatFilter::log(const std::string &message, const LogLevel level) { m_logger->log(message, level); }
+
+void RepeatFilter::exception(const LogException &exception)
+{
+    std::lock_guard lock(m_mutex);
+
+    // Keep the counts in front of the exception they were logged before
+    for (auto &entry: m_window)
+        summarize(entry);
+
+    m_logger->exception(exception);
+}
+
+void RepeatFilter::logRecord(const LogRecord &record)
+{
+    if (record.level < m_minLogLevel or record.level > m_maxLogLevel)
+        return;
+
+    const uint64_t hash = hashRecord(record);
+
+    std::lock_guard lock(m_mutex);
+
+    summarizeExpired(record.timestamp);
+
+    Entry *oldest = &m_window.front();
+    for (auto &entry: m_window)
+    {
+        if (entry.used and entry.hash == hash)
+        {
+            if (entry.repeats++ == 0)
+                entry.firstRepeat = record.timestamp;
+
+            entry.level = record.level;
+            entry.location = record.location;
+            entry.threadId = record.threadId;
+            entry.threadName = record.threadName;
+            entry.lastSeen = record.timestamp;
+            return;
+        }
+
+        if (!entry.used or (oldest->used and entry.lastSeen < oldest->lastSeen))
+            oldest = &entry;
+    }
+
+    // A new record pushes the least recently seen one out, which ends its run
+    summarize(*oldest);
+
+    *oldest = Entry{};
+    oldest->used = true;
+    oldest->hash = hash;
+    oldest->lastSeen = record.timestamp;
+
+    m_logger->logRecord(record);
+}
+
+void RepeatFilter::flush()
+{
+    {
+        std::lock_guard lock(m_mutex);
+
+        for (auto &entry: m_window)
+            summarize(entry);
+    }
+
+    m_logger->flush();
+}
+
+void RepeatFilter::poll()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        summarizeExpired(std::chrono::system_clock::now());
+    }
+
+    m_logger->poll();
+}
+
+void RepeatFilter::summarize(Entry &entry)
+{
+    if (entry.repeats == 0)
+        return;
+
+    m_summary.reset();
+    m_summary.level = entry.level;
+    m_summary.timestamp = entry.lastSeen;
+    m_summary.location = entry.location;
+    m_summary.threadId = entry.threadId;
+    m_summary.threadName = entry.threadName;
+
+    std::string_view file = entry.location.file_name();
+    if (const auto slash = file.find_last_of("/\\"); slash != std::string_view::npos)
+        file.remove_prefix(slash + 1);
+
+    std::array<char, 16> number{};
+    m_summary.message = "Message from ";
+    m_summary.message += file.empty() ? "unknown location" : file;
+    if (entry.location.line() != 0)
+    {
+        char *end = std::to_chars(number.data(), number.data() + number.size(), entry.location.line()).ptr;
+        m_summary.message += ':';
+        m_summary.message.append(number.data(), static_cast<std::size_t>(end - number.data()));
+    }
+
+    char *end = std::to_chars(number.data(), number.data() + number.size(), entry.repeats).ptr;
+    m_summary.message += " repeated ";
+    m_summary.message.append(number.data(), static_cast<std::size_t>(end - number.data()));
+    m_summary.message += " more times";
+
+    entry.repeats = 0;
+    m_logger->logRecord(m_summary);
+}
+
+void RepeatFilter::summarizeExpired(const std::chrono::system_clock::time_point now)
+{
+    for (auto &entry: m_window)
+    {
+        if (entry.repeats != 0 and now - entry.firstRepeat >= m_timeout)
+            summarize(entry);
+    }
+}
+
+} // namespace slog
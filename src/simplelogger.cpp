@@ -2,32 +2,156 @@
 #include "simplelogger.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 
+#include "ringqueue.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+
+#include "flightrecorder.hpp"
+#endif // _WIN32
+
 namespace slog
 {
 
+/* How long the backend sleeps when the queue is empty, producers never notify it */
+constexpr auto BACKEND_IDLE_WAIT = std::chrono::milliseconds(1);
+/* Most records the backend takes from the thread buffers per round, so the staging records stay few and warm */
+constexpr std::size_t MAX_DRAIN_BATCH = 1024;
+/* How often the backend gives the loggers a chance to do time based work, see LoggerLoc::poll */
+constexpr auto BACKEND_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+/* Set on the backend thread so loggers that log from inside log() don't wait on their own queue */
+thread_local bool t_isBackendThread = false;
+
+struct ThreadBuffer
+{
+    explicit ThreadBuffer(const std::size_t capacity) : queue(capacity) {}
+
+    /* Only the owning thread pushes, the backend (or a producer draining after shutdown) pops */
+    RingQueue<LogRecord> queue;
+    /* Set when the thread exits, the buffer is dropped once it's empty */
+    std::atomic<bool> abandoned = false;
+};
+
+namespace
+{
+
+std::atomic<uint64_t> s_nextLoggerId = 1;
+
+/* The calling thread's buffer in every SimpleLogger it logged to asynchronously, usually just one */
+struct ThreadBuffers
+{
+    std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> buffers;
+
+    ~ThreadBuffers()
+    {
+        for (const auto &[id, buffer]: buffers)
+            buffer->abandoned.store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadBuffers t_buffers;
+
+struct ThreadIdentity
+{
+    uint32_t id = 0;
+    ThreadName name;
+};
+
+thread_local ThreadIdentity t_identity;
+
+/* Record the synchronous path fills, reused so its buffers keep their capacity */
+thread_local LogRecord t_record;
+thread_local bool t_recordInUse = false;
+
+/* Filled instead of a queue cell when the backpressure policy drops a record, and what overwritten records go to */
+thread_local LogRecord t_droppedRecord;
+
+uint32_t currentThreadId()
+{
+    if (t_identity.id == 0) [[unlikely]]
+    {
+#ifdef __linux__
+        t_identity.id = static_cast<uint32_t>(gettid());
+#else
+        t_identity.id = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+#endif // __linux__
+
+#ifndef _WIN32
+        // First record from this thread, so a stack overflow in it can still dump the flight recorders
+        FlightRecorder::prepareThread();
+#endif // _WIN32
+    }
+
+    return t_identity.id;
+}
+
+/* Every live SimpleLogger, so a LoggerLoc changing its levels can update the loggers it belongs to */
+std::mutex &instancesMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<SimpleLogger *> &instances()
+{
+    static std::vector<SimpleLogger *> loggers;
+    return loggers;
+}
+
+} // namespace
+
+void notifyLevelsChanged()
+{
+    std::lock_guard lock(instancesMutex());
+
+    for (auto *logger: instances())
+        logger->updateEnabledLevels();
+}
+
+SimpleLogger::SimpleLogger() : m_id(s_nextLoggerId.fetch_add(1, std::memory_order_relaxed))
+{
+    std::lock_guard lock(instancesMutex());
+    instances().push_back(this);
+}
+
 SimpleLogger::~SimpleLogger()
 {
+    shutdown();
     clearLoggers();
 
-    std::cout << "\n\n" << std::endl;
+    {
+        std::lock_guard lock(instancesMutex());
+        std::erase(instances(), this);
+    }
+
+    // Spacing for a terminal only, a pipe or file keeps just the log lines
+    if (isConsoleTerminal(ConsoleStream::STDOUT))
+        std::cout << "\n\n" << std::endl;
 }
 
-std::shared_ptr<SimpleLogger> SimpleLogger::s_GlobalLogger;
+std::atomic<SimpleLogger *> SimpleLogger::s_GlobalLogger = nullptr;
 
-std::shared_ptr<SimpleLogger> SimpleLogger::GlobalLogger()
+SimpleLogger *SimpleLogger::InitGlobalLogger()
 {
-    if (!s_GlobalLogger)
+    /* Function local statics are initialized exactly once even if several threads get here first */
+    static SimpleLogger *globalLogger = []
     {
-        s_GlobalLogger = std::make_unique<SimpleLogger>();
+        static SimpleLogger logger;
+        logger.m_isGlobal = true;
 
-        s_GlobalLogger->addLogger(std::make_shared<ConsoleLogger>());
+        logger.addLogger(std::make_shared<ConsoleLogger>());
         /* Make sure the default logger will log everything */
-        s_GlobalLogger->getLogger(0)->setMinLogLevel(LogLevel::DEBUG);
-    }
+        logger.getLogger(0)->setMinLogLevel(LogLevel::DEBUG);
 
-    return s_GlobalLogger;
+        return &logger;
+    }();
+
+    s_GlobalLogger.store(globalLogger, std::memory_order_release);
+    return globalLogger;
 }
 
 void SimpleLogger::CaptureExceptions()
@@ -44,23 +168,384 @@ void SimpleLogger::CaptureExceptions()
                     SL_LOG_FATAL("Unhandled exception: " + std::string(e.what()));
                 }
 
+                GlobalLogger()->flush();
+
+#ifndef _WIN32
+                FlightRecorder::dumpAll(STDERR_FILENO);
+#endif // _WIN32
+
                 std::abort();
             });
 }
 
-void SimpleLogger::log(const std::string &message, const LogLevel level)
+void SimpleLogger::log(const std::string_view message, const LogLevel level, const std::source_location &location)
+{
+    if (!isLevelEnabled(level))
+        return;
+
+    RecordWriter writer(*this, level, location);
+    writer.record().message = message;
+    writer.commit();
+}
+
+void SimpleLogger::log(const Category &category, const std::string_view message, const LogLevel level,
+                       const std::source_location &location)
+{
+    if (!category.isEnabled(level))
+        return;
+
+    RecordWriter writer(*this, level, location);
+    writer.record().message = message;
+    writer.record().category = category.name();
+    writer.commit();
+}
+
+void SimpleLogger::logEncoded(const LogLevel level, const std::string_view format, std::string &&arguments)
+{
+    if (!isLevelEnabled(level))
+        return;
+
+    RecordWriter writer(*this, level, {});
+    writer.record().format = format;
+    writer.record().arguments.swap(arguments);
+    writer.commit();
+}
+
+void SimpleLogger::logStructured(const LogLevel level, const std::string_view message, std::string &&fields)
+{
+    if (!isLevelEnabled(level))
+        return;
+
+    RecordWriter writer(*this, level, {});
+    writer.record().message = message;
+    writer.record().fields.swap(fields);
+    writer.commit();
+}
+
+SimpleLogger::RecordWriter::RecordWriter(SimpleLogger &logger, const LogLevel level,
+                                         const std::source_location &location) : m_logger(logger)
+{
+    if (logger.m_async.load(std::memory_order_acquire) and !t_isBackendThread)
+    {
+        ThreadBuffer &buffer = logger.threadBuffer();
+        if ((m_record = logger.claimRecord(buffer, level, m_position)) != nullptr)
+        {
+            m_buffer = &buffer;
+        }
+        else
+        {
+            m_dropped = true;
+            m_record = &t_droppedRecord;
+        }
+    }
+    else if (!t_recordInUse)
+    {
+        t_recordInUse = true;
+        m_ownsThreadRecord = true;
+        m_record = &t_record;
+    }
+    else
+    {
+        // A logger logging from inside log(), the thread's record is still being written
+        m_nested = std::make_unique<LogRecord>();
+        m_record = m_nested.get();
+    }
+
+    m_record->reset();
+    m_record->level = level;
+    m_record->timestamp = std::chrono::system_clock::now();
+    m_record->threadId = currentThreadId();
+    m_record->threadName = t_identity.name;
+    m_record->location = location;
+}
+
+SimpleLogger::RecordWriter::~RecordWriter()
+{
+    /* A claimed cell has to be published even if filling it threw, NONE is filtered out by every logger */
+    if (!m_committed and m_buffer != nullptr)
+    {
+        m_record->level = LogLevel::NONE;
+        m_buffer->queue.publish(m_position);
+    }
+
+    if (m_ownsThreadRecord)
+        t_recordInUse = false;
+}
+
+void SimpleLogger::RecordWriter::commit()
 {
-    if (level < m_minLogLevel or level > m_maxLogLevel)
+    m_committed = true;
+    if (m_dropped)
+        return;
+
+    m_logger.m_metrics.addRecord(m_record->level);
+
+    if (m_buffer == nullptr)
+    {
+        m_logger.dispatch(*m_record);
         return;
+    }
+
+    m_buffer->queue.publish(m_position);
+
+    /* shutdown() may have finished draining between our check and the claim, write the record ourselves then */
+    if (!m_logger.m_async.load(std::memory_order_seq_cst))
+        m_logger.drainQueue();
+}
+
+ThreadBuffer &SimpleLogger::threadBuffer()
+{
+    for (const auto &[id, buffer]: t_buffers.buffers)
+    {
+        if (id == m_id)
+            return *buffer;
+    }
+
+    // First asynchronous record from this thread
+    auto buffer = std::make_shared<ThreadBuffer>(m_threadBufferCapacity.load(std::memory_order_relaxed));
+    {
+        std::lock_guard lock(m_threadBuffersMutex);
+        m_threadBuffers.push_back(buffer);
+    }
+
+    t_buffers.buffers.emplace_back(m_id, buffer);
+    return *buffer;
+}
+
+LogRecord *SimpleLogger::claimRecord(ThreadBuffer &buffer, const LogLevel level, std::size_t &position)
+{
+    const BackpressurePolicy policy = m_backpressurePolicy.load(std::memory_order_relaxed);
+
+    // Low records leave the last cells to the ones that always get through
+    if (policy == BackpressurePolicy::DROP_BELOW_LEVEL and level < m_dropBelow.load(std::memory_order_relaxed))
+    {
+        const std::size_t capacity = buffer.queue.capacity();
+        const std::size_t reserved = std::min(m_reservedCapacity.load(std::memory_order_relaxed), capacity - 1);
+        if (buffer.queue.size() >= capacity - reserved)
+        {
+            dropRecord();
+            return nullptr;
+        }
+    }
+
+    LogRecord *record = buffer.queue.tryClaim(position);
+    if (record != nullptr) [[likely]]
+        return record;
+
+    m_metrics.addQueueFullWait();
+    m_backendWake.notify_one();
+
+    if (policy == BackpressurePolicy::DROP_NEWEST)
+    {
+        dropRecord();
+        return nullptr;
+    }
+
+    const auto timeout = std::chrono::nanoseconds(m_blockTimeout.load(std::memory_order_relaxed));
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while ((record = buffer.queue.tryClaim(position)) == nullptr)
+    {
+        if (policy == BackpressurePolicy::OVERWRITE_OLDEST and buffer.queue.tryPop(t_droppedRecord))
+        {
+            // Taken out of the queue without being written, it counts as written so flush() doesn't wait for it
+            dropRecord();
+            m_written.fetch_add(1, std::memory_order_release);
+            continue;
+        }
+
+        if (policy == BackpressurePolicy::BLOCK and timeout.count() > 0 and
+            std::chrono::steady_clock::now() >= deadline)
+        {
+            dropRecord();
+            return nullptr;
+        }
+
+        // Buffer is full, wait for the backend to catch up
+        m_backendWake.notify_one();
+        std::this_thread::yield();
+    }
+
+    return record;
+}
+
+void SimpleLogger::dropRecord()
+{
+    m_metrics.addDropped();
+    m_unreportedDrops.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimpleLogger::reportDrops()
+{
+    const uint64_t dropped = m_unreportedDrops.exchange(0, std::memory_order_relaxed);
+    if (dropped == 0) [[likely]]
+        return;
+
+    LogRecord record;
+    record.level = LogLevel::WARNING;
+    record.timestamp = std::chrono::system_clock::now();
+    record.threadId = currentThreadId();
+    record.threadName = t_identity.name;
+    record.message = "Dropped log records, the log queue was full";
+    encodeFields(record.fields, "dropped", dropped);
+
+    dispatch(record);
+}
+
+void SimpleLogger::setBackpressure(const BackpressureOptions &options)
+{
+    m_blockTimeout.store(std::chrono::duration_cast<std::chrono::nanoseconds>(options.blockTimeout).count(),
+                         std::memory_order_relaxed);
+    m_dropBelow.store(options.dropBelow, std::memory_order_relaxed);
+    m_reservedCapacity.store(options.reservedCapacity, std::memory_order_relaxed);
+    m_backpressurePolicy.store(options.policy, std::memory_order_relaxed);
+}
+
+BackpressureOptions SimpleLogger::getBackpressure() const
+{
+    BackpressureOptions options;
+    options.policy = m_backpressurePolicy.load(std::memory_order_relaxed);
+    options.blockTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::nanoseconds(m_blockTimeout.load(std::memory_order_relaxed)));
+    options.dropBelow = m_dropBelow.load(std::memory_order_relaxed);
+    options.reservedCapacity = m_reservedCapacity.load(std::memory_order_relaxed);
+
+    return options;
+}
+
+std::size_t SimpleLogger::pushedCount()
+{
+    std::lock_guard lock(m_threadBuffersMutex);
+
+    std::size_t pushed = m_retiredPushed;
+    for (const auto &buffer: m_threadBuffers)
+        pushed += buffer->queue.pushedCount();
+
+    return pushed;
+}
+
+void SimpleLogger::setThreadName(const std::string_view name) { t_identity.name = ThreadName(name); }
+
+std::string_view SimpleLogger::getThreadName() { return t_identity.name.view(); }
+
+void SimpleLogger::dispatch(LogRecord &record)
+{
+    /* Format the timestamp once here instead of once per logger */
+    record.time = formatTime(record.timestamp);
+
+    const auto loggers = m_loggerLocs.read();
+
+    /* Deferred messages are formatted into a buffer owned by the thread and lent to the record, record buffers move
+     * between queue cells and would otherwise have to grow again whenever a short one meets a long message */
+    thread_local std::string t_message;
+    const auto needsMessage = [](const auto &loggerLoc)
+    { return loggerLoc != nullptr and loggerLoc->needsFormattedMessage(); };
+    const bool lendMessage =
+            !record.format.empty() and record.message.empty() and std::ranges::any_of(loggers.loggers(), needsMessage);
+
+    if (lendMessage)
+    {
+        t_message.clear();
+        formatDeferred(t_message, record.format, record.arguments);
+        record.message.swap(t_message);
+    }
+
+    /* Every SINK_TIMING_SAMPLE_INTERVAL-th record of the thread is timed in each logger */
+    thread_local uint32_t t_untimed = 0;
+    const bool timed = t_untimed++ % SINK_TIMING_SAMPLE_INTERVAL == 0;
 
     // Log to all loggers (in order)
-    for (auto &loggerLoc: m_loggerLocs)
+    for (const auto &loggerLoc: loggers.loggers())
     {
         if (loggerLoc != nullptr)
         {
-            loggerLoc->log(message, level);
+            SinkMetrics &metrics = loggerLoc->metrics();
+            if (record.level < loggerLoc->getMinLogLevel() or record.level > loggerLoc->getMaxLogLevel())
+                metrics.addFiltered();
+            else
+                metrics.addAccepted();
+
+            if (!timed)
+            {
+                loggerLoc->logRecord(record);
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            loggerLoc->logRecord(record);
+            metrics.addLatency(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                            .count()));
         }
     }
+
+    if (lendMessage)
+        record.message.swap(t_message);
+
+    dumpMetricsIfDue(record.timestamp);
+}
+
+MetricsSnapshot SimpleLogger::metrics()
+{
+    MetricsSnapshot snapshot;
+    m_metrics.fill(snapshot);
+
+    const std::size_t written = m_written.load(std::memory_order_acquire);
+    const std::size_t pushed = pushedCount();
+    snapshot.queueDepth = pushed > written ? pushed - written : 0;
+
+    const auto loggers = m_loggerLocs.read();
+    for (const auto &loggerLoc: loggers.loggers())
+    {
+        if (loggerLoc == nullptr)
+            continue;
+
+        SinkMetricsSnapshot sink = loggerLoc->metrics().snapshot();
+        sink.logger = loggerLoc;
+        sink.name = loggerName(*loggerLoc);
+        snapshot.sinks.push_back(std::move(sink));
+    }
+
+    return snapshot;
+}
+
+void SimpleLogger::setMetricsDump(const std::shared_ptr<LoggerLoc> &loggerLoc, const std::chrono::milliseconds interval)
+{
+    std::lock_guard lock(m_metricsDumpMutex);
+
+    m_metricsDumpLogger = loggerLoc;
+    m_metricsDumpInterval = interval;
+
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    m_nextMetricsDump.store(loggerLoc == nullptr or interval.count() <= 0
+                                    ? 0
+                                    : std::chrono::duration_cast<std::chrono::nanoseconds>(now + interval).count(),
+                            std::memory_order_relaxed);
+}
+
+void SimpleLogger::dumpMetricsIfDue(const std::chrono::system_clock::time_point now)
+{
+    int64_t due = m_nextMetricsDump.load(std::memory_order_relaxed);
+    const int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+
+    if (due == 0 or time < due) [[likely]]
+        return;
+
+    std::shared_ptr<LoggerLoc> loggerLoc;
+    {
+        std::lock_guard lock(m_metricsDumpMutex);
+
+        // Whoever moves the due time forward writes the dump
+        if (!m_nextMetricsDump.compare_exchange_strong(
+                    due, time + std::chrono::duration_cast<std::chrono::nanoseconds>(m_metricsDumpInterval).count(),
+                    std::memory_order_relaxed))
+            return;
+
+        loggerLoc = m_metricsDumpLogger;
+    }
+
+    if (loggerLoc != nullptr)
+        logMetrics(*loggerLoc, metrics());
 }
 
 void SimpleLogger::exception(const LogException &exception)
@@ -69,8 +554,14 @@ void SimpleLogger::exception(const LogException &exception)
     if (m_maxLogLevel < LogLevel::FATAL)
         return;
 
+    /* Keep exceptions in order with everything queued before them */
+    if (!t_isBackendThread)
+        flush();
+
+    const auto loggers = m_loggerLocs.read();
+
     // Log to all loggers (in order)
-    for (auto &loggerLoc: m_loggerLocs)
+    for (const auto &loggerLoc: loggers.loggers())
     {
         if (loggerLoc != nullptr)
         {
@@ -79,16 +570,259 @@ void SimpleLogger::exception(const LogException &exception)
     }
 }
 
-void SimpleLogger::setMaxLogLevel(const LogLevel level) { m_maxLogLevel = level; }
+void SimpleLogger::startAsync(const std::size_t queueCapacity)
+{
+    if (m_async.load())
+        return;
+
+    std::lock_guard lock(m_backendMutex);
+
+    /* Only threads that haven't logged asynchronously yet get buffers of the new capacity */
+    m_threadBufferCapacity.store(queueCapacity, std::memory_order_relaxed);
+    m_stopBackend = false;
+
+    m_backend = std::thread(&SimpleLogger::backendLoop, this);
+    m_async.store(true, std::memory_order_seq_cst);
+}
+
+void SimpleLogger::flush()
+{
+    m_metrics.addFlush();
+
+    if (!m_async.load(std::memory_order_acquire) or t_isBackendThread)
+    {
+        flushLoggers();
+        return;
+    }
+
+    const std::size_t target = pushedCount();
+
+    std::unique_lock lock(m_backendMutex);
+    m_flushTarget = std::max(m_flushTarget, target);
+    m_backendWake.notify_one();
+    m_backendDrained.wait(lock, [&] { return m_flushedUpTo >= target or m_stopBackend; });
+}
+
+void SimpleLogger::shutdown()
+{
+    if (!m_async.exchange(false, std::memory_order_seq_cst))
+        return;
+
+    {
+        std::lock_guard lock(m_backendMutex);
+        m_stopBackend = true;
+    }
+    m_backendWake.notify_one();
+    m_backendDrained.notify_all();
+
+    if (m_backend.joinable())
+        m_backend.join();
+
+    // Anything pushed while the backend was stopping
+    drainQueue();
+    flushLoggers();
+}
+
+void SimpleLogger::flushLoggers()
+{
+    const auto loggers = m_loggerLocs.read();
+
+    for (const auto &loggerLoc: loggers.loggers())
+    {
+        if (loggerLoc != nullptr)
+        {
+            loggerLoc->flush();
+        }
+    }
+}
+
+bool SimpleLogger::drainQueue()
+{
+    std::lock_guard lock(m_drainMutex);
+
+    std::size_t staged = 0;
+    std::size_t sources = 0;
+    {
+        std::lock_guard buffersLock(m_threadBuffersMutex);
+
+        // Buffers of exited threads go away once the last of their records was taken
+        std::erase_if(m_threadBuffers,
+                      [this](const std::shared_ptr<ThreadBuffer> &buffer)
+                      {
+                          if (!buffer->abandoned.load(std::memory_order_acquire) or buffer->queue.size() != 0)
+                              return false;
+
+                          m_retiredPushed += buffer->queue.pushedCount();
+                          return true;
+                      });
+
+        // Start at a different buffer every round so a busy thread can't keep the others waiting
+        const std::size_t bufferCount = m_threadBuffers.size();
+        m_drainStart++;
+
+        for (std::size_t b = 0; b < bufferCount and staged < MAX_DRAIN_BATCH; b++)
+        {
+            const auto &buffer = m_threadBuffers[(m_drainStart + b) % bufferCount];
+            const std::size_t before = staged;
+
+            while (staged < MAX_DRAIN_BATCH)
+            {
+                if (staged == m_staging.size())
+                    m_staging.emplace_back();
+
+                if (!buffer->queue.tryPop(m_staging[staged]))
+                    break;
+
+                staged++;
+            }
+
+            if (staged != before)
+                sources++;
+        }
+    }
+
+    if (staged == 0)
+    {
+        reportDrops();
+        return false;
+    }
+
+    m_order.clear();
+    for (std::size_t i = 0; i < staged; i++)
+        m_order.push_back(&m_staging[i]);
+
+    // Every buffer is in order already, only records from different threads need merging (by address when the
+    // timestamps are equal, which keeps each buffer's order without stable_sort's temporary buffer)
+    if (sources > 1)
+    {
+        std::ranges::sort(m_order,
+                          [](const LogRecord *left, const LogRecord *right)
+                          {
+                              return left->timestamp < right->timestamp or
+                                     (left->timestamp == right->timestamp and left < right);
+                          });
+    }
+
+    for (auto *record: m_order)
+        dispatch(*record);
+
+    m_written.fetch_add(staged, std::memory_order_release);
+    reportDrops();
+
+    return true;
+}
+
+void SimpleLogger::pollLoggers()
+{
+    const auto loggers = m_loggerLocs.read();
+
+    for (const auto &loggerLoc: loggers.loggers())
+    {
+        if (loggerLoc != nullptr)
+        {
+            loggerLoc->poll();
+        }
+    }
+}
+
+void SimpleLogger::backendLoop()
+{
+    t_isBackendThread = true;
+    auto lastPoll = std::chrono::steady_clock::now();
+
+    while (true)
+    {
+        const bool drained = drainQueue();
+
+        if (const auto now = std::chrono::steady_clock::now(); now - lastPoll >= BACKEND_POLL_INTERVAL)
+        {
+            pollLoggers();
+            lastPoll = now;
 
-void SimpleLogger::setMinLogLevel(const LogLevel level) { m_minLogLevel = level; }
+            // Limited call sites log through the global logger, report the ones that went quiet
+            if (this == s_GlobalLogger.load(std::memory_order_acquire))
+                CallSiteLimiter::summarizeAll(false);
+
+            dumpMetricsIfDue(std::chrono::system_clock::now());
+        }
+        const std::size_t written = m_written.load(std::memory_order_acquire);
+
+        std::unique_lock lock(m_backendMutex);
+
+        if (m_flushTarget > m_flushedUpTo and written >= m_flushTarget)
+        {
+            lock.unlock();
+            flushLoggers();
+            lock.lock();
+
+            m_flushedUpTo = written;
+            m_backendDrained.notify_all();
+            continue;
+        }
+
+        if (m_stopBackend)
+        {
+            if (written >= pushedCount())
+                break;
+
+            continue;
+        }
+
+        if (drained)
+            continue;
+
+        if (m_flushTarget > m_flushedUpTo)
+        {
+            // A push is still in progress, check again shortly
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+
+        m_backendWake.wait_for(lock, BACKEND_IDLE_WAIT);
+    }
+}
+
+void SimpleLogger::setMaxLogLevel(const LogLevel level)
+{
+    m_maxLogLevel = level;
+    updateEnabledLevels();
+}
+
+void SimpleLogger::setMinLogLevel(const LogLevel level)
+{
+    m_minLogLevel = level;
+    updateEnabledLevels();
+}
+
+void SimpleLogger::updateEnabledLevels()
+{
+    /* Serialized so an older computation can never overwrite a newer one */
+    std::lock_guard lock(m_enabledLevelsMutex);
+
+    uint8_t loggerLevels = 0;
+    {
+        const auto loggers = m_loggerLocs.read();
+        for (const auto &loggerLoc: loggers.loggers())
+        {
+            if (loggerLoc != nullptr)
+                loggerLevels |= loggerLoc->getEnabledLevels();
+        }
+    }
+
+    m_enabledLevels.store(loggerLevels & levelRangeMask(m_minLogLevel, m_maxLogLevel), std::memory_order_relaxed);
+
+    if (m_isGlobal)
+        Category::updateGlobalLevels(loggerLevels, m_minLogLevel, m_maxLogLevel);
+}
 
 void SimpleLogger::addLogger(const std::shared_ptr<LoggerLoc> &loggerLoc)
 {
     if (loggerLoc == nullptr)
         return;
 
-    m_loggerLocs.push_back(loggerLoc);
+    m_loggerLocs.add(loggerLoc);
+    updateEnabledLevels();
 }
 
 void SimpleLogger::removeLogger(const std::shared_ptr<LoggerLoc> &loggerLoc)
@@ -96,18 +830,16 @@ void SimpleLogger::removeLogger(const std::shared_ptr<LoggerLoc> &loggerLoc)
     if (loggerLoc == nullptr)
         return;
 
-    if (const auto logger = std::ranges::find(m_loggerLocs, loggerLoc); logger != m_loggerLocs.end())
-        m_loggerLocs.erase(logger);
+    m_loggerLocs.remove(loggerLoc);
+    updateEnabledLevels();
 }
 
-void SimpleLogger::clearLoggers() { m_loggerLocs.clear(); }
-
-std::shared_ptr<LoggerLoc> SimpleLogger::getLogger(const uint32_t index)
+void SimpleLogger::clearLoggers()
 {
-    if (index >= m_loggerLocs.size())
-        return nullptr;
-
-    return m_loggerLocs[index];
+    m_loggerLocs.clear();
+    updateEnabledLevels();
 }
 
+std::shared_ptr<LoggerLoc> SimpleLogger::getLogger(const uint32_t index) { return m_loggerLocs.get(index); }
+
 } // namespace slog
@@ -0,0 +1,188 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "sinkregistry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <thread>
+
+#include "ringqueue.hpp"
+
+namespace slog
+{
+
+namespace
+{
+
+/* Threads beyond this share a counter instead of a slot */
+constexpr std::size_t MAX_READER_SLOTS = 256;
+
+struct alignas(CACHE_LINE_SIZE) ReaderSlot
+{
+    /* Epoch the thread entered its read section at, 0 while it isn't reading */
+    std::atomic<uint64_t> epoch = 0;
+    std::atomic<bool> used = false;
+};
+
+std::array<ReaderSlot, MAX_READER_SLOTS> s_readerSlots;
+alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> s_epoch = 1;
+alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> s_overflowReaders = 0;
+
+struct ThreadReader
+{
+    ReaderSlot *slot = nullptr;
+    bool overflow = false;
+    uint32_t depth = 0;
+
+    ~ThreadReader()
+    {
+        if (slot != nullptr)
+            slot->used.store(false, std::memory_order_release);
+    }
+
+    void acquireSlot()
+    {
+        for (auto &candidate: s_readerSlots)
+        {
+            bool expected = false;
+            if (!candidate.used.load(std::memory_order_relaxed) and
+                candidate.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                slot = &candidate;
+                return;
+            }
+        }
+
+        overflow = true;
+    }
+
+    void enter()
+    {
+        if (depth++ > 0)
+            return;
+
+        if (slot == nullptr and !overflow)
+            acquireSlot();
+
+        if (slot != nullptr)
+            slot->epoch.store(s_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        else
+            s_overflowReaders.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void leave()
+    {
+        if (--depth > 0)
+            return;
+
+        if (slot != nullptr)
+            slot->epoch.store(0, std::memory_order_release);
+        else
+            s_overflowReaders.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+thread_local ThreadReader t_reader;
+
+/** Wait until every read section that could have seen an unpublished snapshot has ended */
+void synchronizeReaders()
+{
+    const uint64_t epoch = s_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    for (auto &slot: s_readerSlots)
+    {
+        while (true)
+        {
+            const uint64_t readerEpoch = slot.epoch.load(std::memory_order_acquire);
+            if (readerEpoch == 0 or readerEpoch >= epoch)
+                break;
+
+            std::this_thread::yield();
+        }
+    }
+
+    while (s_overflowReaders.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+}
+
+} // namespace
+
+SinkRegistry::ReadGuard::ReadGuard(const SinkRegistry &registry)
+{
+    t_reader.enter();
+    m_snapshot = registry.m_snapshot.load(std::memory_order_seq_cst);
+}
+
+SinkRegistry::ReadGuard::~ReadGuard() { t_reader.leave(); }
+
+SinkRegistry::SinkRegistry() : m_snapshot(new LoggerList()) {}
+
+SinkRegistry::~SinkRegistry()
+{
+    /* The owner is going away, nobody can be reading anymore */
+    delete m_snapshot.load();
+
+    for (const auto *snapshot: m_retired)
+        delete snapshot;
+}
+
+void SinkRegistry::add(const std::shared_ptr<LoggerLoc> &loggerLoc)
+{
+    std::lock_guard lock(m_writeMutex);
+
+    auto *snapshot = new LoggerList(*m_snapshot.load(std::memory_order_relaxed));
+    snapshot->push_back(loggerLoc);
+
+    publish(snapshot);
+}
+
+void SinkRegistry::remove(const std::shared_ptr<LoggerLoc> &loggerLoc)
+{
+    std::lock_guard lock(m_writeMutex);
+
+    const auto *current = m_snapshot.load(std::memory_order_relaxed);
+    const auto logger = std::ranges::find(*current, loggerLoc);
+    if (logger == current->end())
+        return;
+
+    auto *snapshot = new LoggerList(*current);
+    snapshot->erase(snapshot->begin() + (logger - current->begin()));
+
+    publish(snapshot);
+}
+
+void SinkRegistry::clear()
+{
+    std::lock_guard lock(m_writeMutex);
+
+    publish(new LoggerList());
+}
+
+std::shared_ptr<LoggerLoc> SinkRegistry::get(const uint32_t index) const
+{
+    const auto guard = read();
+
+    if (index >= guard.loggers().size())
+        return nullptr;
+
+    return guard.loggers()[index];
+}
+
+std::size_t SinkRegistry::size() const { return read().loggers().size(); }
+
+void SinkRegistry::publish(const LoggerList *snapshot)
+{
+    m_retired.push_back(m_snapshot.exchange(snapshot, std::memory_order_seq_cst));
+
+    /* A logger changing the list from inside log() would wait on itself, free the old snapshots on a later change */
+    if (t_reader.depth > 0)
+        return;
+
+    synchronizeReaders();
+
+    for (const auto *retired: m_retired)
+        delete retired;
+
+    m_retired.clear();
+}
+
+} // namespace slog
@@ -0,0 +1,328 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "structuredlog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace slog
+{
+
+namespace
+{
+
+template<typename T>
+bool takeRaw(std::string_view &in, T &value)
+{
+    if (in.size() < sizeof(T))
+        return false;
+
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+bool takeString(std::string_view &in, std::string_view &value)
+{
+    uint32_t length = 0;
+    if (in.empty() or static_cast<ArgType>(in.front()) != ArgType::STRING)
+        return false;
+
+    in.remove_prefix(1);
+    if (!takeRaw(in, length) or in.size() < length)
+        return false;
+
+    value = in.substr(0, length);
+    in.remove_prefix(length);
+    return true;
+}
+
+template<typename T>
+void appendNumber(std::string &out, const T value)
+{
+    std::array<char, 32> digits{};
+    const char *end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    out.append(digits.data(), static_cast<std::size_t>(end - digits.data()));
+}
+
+void appendHex(std::string &out, const uint64_t value)
+{
+    std::array<char, 16> digits{};
+    const char *end = std::to_chars(digits.data(), digits.data() + digits.size(), value, 16).ptr;
+    out += "0x";
+    out.append(digits.data(), static_cast<std::size_t>(end - digits.data()));
+}
+
+/* Numbers, booleans and pointers never need quoting in either format */
+bool appendPlainValue(std::string &out, const FieldValue &value)
+{
+    switch (value.type)
+    {
+        case ArgType::BOOL:
+            out += value.boolean ? "true" : "false";
+            return true;
+        case ArgType::INT64:
+            appendNumber(out, value.integer);
+            return true;
+        case ArgType::UINT64:
+            appendNumber(out, value.unsignedInteger);
+            return true;
+        case ArgType::DOUBLE:
+            if (!std::isfinite(value.number))
+                return false;
+            appendNumber(out, value.number);
+            return true;
+        case ArgType::POINTER:
+            appendHex(out, value.pointer);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool needsLogfmtQuotes(const std::string_view value)
+{
+    if (value.empty())
+        return true;
+
+    for (const char character: value)
+    {
+        if (static_cast<unsigned char>(character) <= ' ' or character == '=' or character == '"' or
+            character == '\\')
+            return true;
+    }
+
+    return false;
+}
+
+void appendLogfmtValue(std::string &out, const std::string_view value)
+{
+    if (!needsLogfmtQuotes(value))
+    {
+        out += value;
+        return;
+    }
+
+    // logfmt has no escaping rules of its own, JSON's are what parsers accept
+    appendJsonString(out, value);
+}
+
+void appendLogfmtThread(std::string &out, const LogRecord &record)
+{
+    if (record.threadId == 0)
+        return;
+
+    out += " thread=";
+    appendNumber(out, record.threadId);
+
+    if (!record.threadName.empty())
+    {
+        out += " thread_name=";
+        appendLogfmtValue(out, record.threadName.view());
+    }
+}
+
+/* Keys JsonFileLogger writes itself, fields with these names get a "field." prefix */
+constexpr std::array<std::string_view, 6> JSON_RECORD_KEYS = {"time",   "level",       "category",
+                                                              "thread", "thread_name", "message"};
+
+} // namespace
+
+bool nextField(std::string_view &fields, std::string_view &key, FieldValue &value)
+{
+    if (!takeString(fields, key) or fields.empty())
+        return false;
+
+    value.type = static_cast<ArgType>(fields.front());
+    value.string = {};
+    fields.remove_prefix(1);
+
+    switch (value.type)
+    {
+        case ArgType::BOOL:
+        {
+            char raw = 0;
+            if (!takeRaw(fields, raw))
+                return false;
+            value.boolean = raw != 0;
+            return true;
+        }
+        case ArgType::CHAR:
+            if (!takeRaw(fields, value.character))
+                return false;
+            value.string = std::string_view(&value.character, 1);
+            return true;
+        case ArgType::INT64:
+            return takeRaw(fields, value.integer);
+        case ArgType::UINT64:
+            return takeRaw(fields, value.unsignedInteger);
+        case ArgType::DOUBLE:
+            return takeRaw(fields, value.number);
+        case ArgType::POINTER:
+            return takeRaw(fields, value.pointer);
+        case ArgType::STRING:
+        {
+            uint32_t length = 0;
+            if (!takeRaw(fields, length) or fields.size() < length)
+                return false;
+            value.string = fields.substr(0, length);
+            fields.remove_prefix(length);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void formatLogfmtFields(std::string &out, std::string_view fields)
+{
+    std::string_view key;
+    FieldValue value;
+
+    while (nextField(fields, key, value))
+    {
+        out += ' ';
+        out += key;
+        out += '=';
+
+        if (!appendPlainValue(out, value))
+        {
+            if (value.type == ArgType::DOUBLE)
+                appendNumber(out, value.number); // inf and nan are fine unquoted in logfmt
+            else
+                appendLogfmtValue(out, value.string);
+        }
+    }
+}
+
+void formatJsonFields(std::string &out, std::string_view fields)
+{
+    std::string_view key;
+    FieldValue value;
+
+    while (nextField(fields, key, value))
+    {
+        out += ',';
+        const std::size_t keyStart = out.size();
+        appendJsonString(out, key);
+
+        // Keeps keys unique, a second "time" or "message" would replace the record's own in most parsers
+        if (std::ranges::find(JSON_RECORD_KEYS, key) != JSON_RECORD_KEYS.end())
+            out.insert(keyStart + 1, "field.");
+
+        out += ':';
+
+        if (appendPlainValue(out, value))
+            continue;
+
+        if (value.type == ArgType::DOUBLE)
+            out += "null"; // JSON has no inf or nan
+        else
+            appendJsonString(out, value.string);
+    }
+}
+
+void appendJsonString(std::string &out, const std::string_view value)
+{
+    constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+
+    out += '"';
+
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < value.size(); i++)
+    {
+        const auto character = static_cast<unsigned char>(value[i]);
+        if (character >= 0x20 and character != '"' and character != '\\')
+            continue;
+
+        out.append(value.substr(start, i - start));
+        start = i + 1;
+
+        switch (character)
+        {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                out += "\\u00";
+                out += HEX_DIGITS[character >> 4];
+                out += HEX_DIGITS[character & 0xf];
+                break;
+        }
+    }
+
+    out.append(value.substr(start));
+    out += '"';
+}
+
+JsonFileLogger::JsonFileLogger(const std::string &filename, const LogFileMode mode) : FileLogger(filename, mode) {}
+
+void JsonFileLogger::formatRecord(std::string &out, const LogRecord &record)
+{
+    out += R"({"time":")";
+    out += formatRfc3339Time(record.timestamp).view();
+    out += R"(","level":")";
+    out += levelName(record.level);
+    out += '"';
+
+    if (!record.category.empty())
+    {
+        out += R"(,"category":)";
+        appendJsonString(out, record.category);
+    }
+
+    if (record.threadId != 0)
+    {
+        out += R"(,"thread":)";
+        appendNumber(out, record.threadId);
+
+        if (!record.threadName.empty())
+        {
+            out += R"(,"thread_name":)";
+            appendJsonString(out, record.threadName.view());
+        }
+    }
+
+    out += R"(,"message":)";
+    appendJsonString(out, record.message);
+    formatJsonFields(out, record.fields);
+    out += "}\n";
+}
+
+LogfmtFileLogger::LogfmtFileLogger(const std::string &filename, const LogFileMode mode) : FileLogger(filename, mode)
+{
+}
+
+void LogfmtFileLogger::formatRecord(std::string &out, const LogRecord &record)
+{
+    out += "time=\"";
+    out += getTime(record).view();
+    out += "\" level=";
+    out += levelName(record.level);
+    if (!record.category.empty())
+    {
+        out += " category=";
+        appendLogfmtValue(out, record.category);
+    }
+    appendLogfmtThread(out, record);
+    out += " msg=";
+    appendLogfmtValue(out, record.message);
+    formatLogfmtFields(out, record.fields);
+    out += '\n';
+}
+
+} // namespace slog
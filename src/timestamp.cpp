@@ -0,0 +1,195 @@
+/* Created by Matthew Brown on 6/15/2024 */
+#include "timestamp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <limits>
+
+namespace slog
+{
+
+namespace
+{
+
+/* "dd/mm/yyyy hh:mm:" */
+constexpr std::size_t MINUTE_PREFIX_LENGTH = 17;
+
+std::atomic<TimeZone> s_timeZone = TimeZone::LOCAL;
+std::atomic<TimePrecision> s_precision = TimePrecision::MILLISECONDS;
+/* Bumped whenever a setting changes so every thread rebuilds its cached prefix */
+std::atomic<uint32_t> s_settingsGeneration = 1;
+
+struct MinuteCache
+{
+    int64_t minute = std::numeric_limits<int64_t>::min();
+    uint32_t generation = 0;
+    std::array<char, MINUTE_PREFIX_LENGTH> prefix{};
+};
+
+thread_local MinuteCache t_cache;
+thread_local MinuteCache t_rfc3339Cache;
+
+void writeDigits(char *out, uint64_t value, const int width)
+{
+    for (int i = width - 1; i >= 0; i--)
+    {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+int64_t floorDiv(const int64_t value, const int64_t divisor)
+{
+    int64_t quotient = value / divisor;
+    if (value % divisor != 0 and value < 0)
+        quotient--;
+
+    return quotient;
+}
+
+void buildPrefix(MinuteCache &cache, const int64_t minute, const uint32_t generation)
+{
+    const std::tm calendar = toCalendarTime(static_cast<std::time_t>(minute * 60));
+
+    char *out = cache.prefix.data();
+    writeDigits(out, calendar.tm_mday, 2);
+    out[2] = '/';
+    writeDigits(out + 3, calendar.tm_mon + 1, 2);
+    out[5] = '/';
+    writeDigits(out + 6, calendar.tm_year + 1900, 4);
+    out[10] = ' ';
+    writeDigits(out + 11, calendar.tm_hour, 2);
+    out[13] = ':';
+    writeDigits(out + 14, calendar.tm_min, 2);
+    out[16] = ':';
+
+    cache.minute = minute;
+    cache.generation = generation;
+}
+
+/* "yyyy-mm-ddThh:mm:" in UTC, the same length as the display prefix */
+void buildRfc3339Prefix(MinuteCache &cache, const int64_t minute, const uint32_t generation)
+{
+    const auto seconds = static_cast<std::time_t>(minute * 60);
+    std::tm calendar{};
+#ifdef _WIN32
+    gmtime_s(&calendar, &seconds);
+#else
+    gmtime_r(&seconds, &calendar);
+#endif
+
+    char *out = cache.prefix.data();
+    writeDigits(out, calendar.tm_year + 1900, 4);
+    out[4] = '-';
+    writeDigits(out + 5, calendar.tm_mon + 1, 2);
+    out[7] = '-';
+    writeDigits(out + 8, calendar.tm_mday, 2);
+    out[10] = 'T';
+    writeDigits(out + 11, calendar.tm_hour, 2);
+    out[13] = ':';
+    writeDigits(out + 14, calendar.tm_min, 2);
+    out[16] = ':';
+
+    cache.minute = minute;
+    cache.generation = generation;
+}
+
+/* Cached minute prefix, then "ss.fff" with the fraction digits of the precision setting */
+FormattedTime formatWithPrefix(const std::chrono::system_clock::time_point time, MinuteCache &cache,
+                               void (*build)(MinuteCache &, int64_t, uint32_t))
+{
+    const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    const int64_t seconds = floorDiv(nanoseconds, 1'000'000'000);
+    const int64_t fraction = nanoseconds - seconds * 1'000'000'000;
+    const int64_t minute = floorDiv(seconds, 60);
+
+    // Time zone offsets only ever change on a minute boundary, so the prefix is valid for the whole minute
+    const uint32_t generation = s_settingsGeneration.load(std::memory_order_acquire);
+    if (cache.minute != minute or cache.generation != generation)
+        build(cache, minute, generation);
+
+    const int digits = static_cast<int>(s_precision.load(std::memory_order_relaxed));
+
+    FormattedTime formatted;
+    char *out = formatted.data.data();
+
+    std::copy(cache.prefix.begin(), cache.prefix.end(), out);
+    out += MINUTE_PREFIX_LENGTH;
+
+    writeDigits(out, seconds - minute * 60, 2);
+    out[2] = '.';
+
+    uint64_t scaled = fraction;
+    for (int i = digits; i < 9; i++)
+        scaled /= 10;
+    writeDigits(out + 3, scaled, digits);
+
+    formatted.length = static_cast<uint8_t>(MINUTE_PREFIX_LENGTH + 3 + digits);
+    return formatted;
+}
+
+} // namespace
+
+FormattedTime formatTime(const std::chrono::system_clock::time_point time)
+{
+    return formatWithPrefix(time, t_cache, buildPrefix);
+}
+
+FormattedTime formatRfc3339Time(const std::chrono::system_clock::time_point time)
+{
+    FormattedTime formatted = formatWithPrefix(time, t_rfc3339Cache, buildRfc3339Prefix);
+    formatted.data[formatted.length++] = 'Z';
+    return formatted;
+}
+
+void setTimeZone(const TimeZone timeZone)
+{
+    s_timeZone.store(timeZone, std::memory_order_relaxed);
+    s_settingsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+TimeZone getTimeZone() { return s_timeZone.load(std::memory_order_relaxed); }
+
+void setTimePrecision(const TimePrecision precision)
+{
+    s_precision.store(precision, std::memory_order_relaxed);
+    s_settingsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+TimePrecision getTimePrecision() { return s_precision.load(std::memory_order_relaxed); }
+
+std::tm toCalendarTime(const std::time_t seconds)
+{
+    std::tm calendar{};
+
+#ifdef _WIN32
+    if (s_timeZone.load(std::memory_order_relaxed) == TimeZone::UTC)
+        gmtime_s(&calendar, &seconds);
+    else
+        localtime_s(&calendar, &seconds);
+#else
+    if (s_timeZone.load(std::memory_order_relaxed) == TimeZone::UTC)
+        gmtime_r(&seconds, &calendar);
+    else
+        localtime_r(&seconds, &calendar);
+#endif
+
+    return calendar;
+}
+
+std::time_t fromCalendarTime(std::tm calendar, const TimeZone timeZone)
+{
+    // Let mktime work out whether daylight saving applies
+    calendar.tm_isdst = -1;
+
+#ifdef _WIN32
+    return timeZone == TimeZone::UTC ? _mkgmtime(&calendar) : std::mktime(&calendar);
+#else
+    return timeZone == TimeZone::UTC ? timegm(&calendar) : std::mktime(&calendar);
+#endif
+}
+
+uint32_t getTimeSettingsGeneration() { return s_settingsGeneration.load(std::memory_order_acquire); }
+
+} // namespace slog
@@ -0,0 +1,89 @@
+/*
+ * @brief Prints binary logs written by BinaryFileLogger as text
+ *
+ * Usage: slog-decode [--utc] [--precision ms|us|ns] <file>...
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binarylog.hpp"
+
+namespace
+{
+
+int usage()
+{
+    std::cerr << "Usage: slog-decode [--utc] [--precision ms|us|ns] <file>..." << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(const int argc, char **argv)
+{
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+
+        if (argument == "--utc")
+        {
+            slog::setTimeZone(slog::TimeZone::UTC);
+        }
+        else if (argument == "--precision" and i + 1 < argc)
+        {
+            const std::string_view precision = argv[++i];
+            if (precision == "ms")
+                slog::setTimePrecision(slog::TimePrecision::MILLISECONDS);
+            else if (precision == "us")
+                slog::setTimePrecision(slog::TimePrecision::MICROSECONDS);
+            else if (precision == "ns")
+                slog::setTimePrecision(slog::TimePrecision::NANOSECONDS);
+            else
+                return usage();
+        }
+        else if (argument.starts_with("-"))
+        {
+            return usage();
+        }
+        else
+        {
+            files.emplace_back(argument);
+        }
+    }
+
+    if (files.empty())
+        return usage();
+
+    slog::LogRecord record;
+    std::string line;
+
+    for (const auto &file: files)
+    {
+        try
+        {
+            slog::BinaryLogReader reader(file);
+            while (reader.next(record))
+            {
+                line.clear();
+                slog::formatLogLine(line, record);
+                std::fwrite(line.data(), 1, line.size(), stdout);
+            }
+        }
+        catch (const slog::LogException &exception)
+        {
+            std::fflush(stdout);
+            std::cerr << "slog-decode: " << file << ": " << exception.what() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,319 @@
+/*
+ * @brief Prints the lines of a FileLogger file from a time range and/or of some levels, reading only what its index
+ * (see FileLogger::setIndexPolicy) says can match
+ *
+ * Usage: slog-query [--utc] [--from TIME] [--to TIME] [--level LEVEL[,LEVEL...]] [--min-level LEVEL] [--stats] <file>
+ *
+ * TIME is "yyyy-mm-dd[ hh:mm[:ss]]" (or with a T between date and time) in the local time zone, or UTC with --utc,
+ * --from is inclusive and --to exclusive. Lines are matched by the "[dd/mm/yyyy hh:mm:ss.fff   LEVEL]" start of the
+ * default layout, lines that don't start like that belong to the record before them. Files with a different layout
+ * are filtered by index entry only. Without an index the whole file is read.
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logexception.hpp"
+#include "logindex.hpp"
+#include "logpattern.hpp"
+#include "timestamp.hpp"
+
+namespace
+{
+
+constexpr std::size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+struct Query
+{
+    int64_t fromNs = std::numeric_limits<int64_t>::min();
+    int64_t toNs = std::numeric_limits<int64_t>::max();
+    uint8_t levels = slog::levelRangeMask(slog::LogLevel::DEBUG, slog::LogLevel::FATAL);
+    bool utc = false;
+};
+
+int usage()
+{
+    std::cerr << "Usage: slog-query [--utc] [--from TIME] [--to TIME] [--level LEVEL[,LEVEL...]] [--min-level LEVEL] "
+                 "[--stats] <file>"
+              << std::endl;
+    return 2;
+}
+
+std::time_t toSeconds(const std::tm &calendar, const bool utc)
+{
+    return slog::fromCalendarTime(calendar, utc ? slog::TimeZone::UTC : slog::TimeZone::LOCAL);
+}
+
+bool parseLevel(const std::string_view name, slog::LogLevel &level)
+{
+    for (uint8_t i = 0; i <= static_cast<uint8_t>(slog::LogLevel::FATAL); i++)
+    {
+        if (slog::levelName(static_cast<slog::LogLevel>(i)) == name)
+        {
+            level = static_cast<slog::LogLevel>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool parseLevels(std::string_view names, uint8_t &levels)
+{
+    levels = 0;
+    while (!names.empty())
+    {
+        const auto comma = names.find(',');
+        slog::LogLevel level{};
+        if (!parseLevel(names.substr(0, comma), level))
+            return false;
+
+        levels |= slog::levelBit(level);
+        names.remove_prefix(comma == std::string_view::npos ? names.size() : comma + 1);
+    }
+
+    return levels != 0;
+}
+
+bool parseQueryTime(const std::string &text, const bool utc, int64_t &ns)
+{
+    std::tm calendar{};
+    char separator = ' ';
+    const int fields = std::sscanf(text.c_str(), "%d-%d-%d%c%d:%d:%d", &calendar.tm_year, &calendar.tm_mon,
+                                   &calendar.tm_mday, &separator, &calendar.tm_hour, &calendar.tm_min,
+                                   &calendar.tm_sec);
+    if (fields != 3 and fields < 6)
+        return false;
+    if (fields > 3 and separator != ' ' and separator != 'T')
+        return false;
+
+    calendar.tm_year -= 1900;
+    calendar.tm_mon -= 1;
+
+    ns = static_cast<int64_t>(toSeconds(calendar, utc)) * 1'000'000'000;
+    return true;
+}
+
+/* Reads "[dd/mm/yyyy hh:mm:ss[.fraction] LEVEL]" with the calendar part converted once per minute */
+class LineParser
+{
+public:
+    explicit LineParser(const bool utc) : m_utc(utc) {}
+
+    bool parse(const std::string_view line, int64_t &ns, slog::LogLevel &level)
+    {
+        constexpr std::string_view SHAPE = "[00/00/0000 00:00:00";
+        if (line.size() < SHAPE.size())
+            return false;
+
+        for (std::size_t i = 0; i < SHAPE.size(); i++)
+        {
+            if ((SHAPE[i] == '0') != (line[i] >= '0' and line[i] <= '9') or (SHAPE[i] != '0' and SHAPE[i] != line[i]))
+                return false;
+        }
+
+        const std::string_view minute = line.substr(1, 16);
+        if (minute != std::string_view(m_minute.data(), m_minute.size()))
+        {
+            std::tm calendar{};
+            calendar.tm_mday = number(line.substr(1, 2));
+            calendar.tm_mon = number(line.substr(4, 2)) - 1;
+            calendar.tm_year = number(line.substr(7, 4)) - 1900;
+            calendar.tm_hour = number(line.substr(12, 2));
+            calendar.tm_min = number(line.substr(15, 2));
+
+            m_minuteNs = static_cast<int64_t>(toSeconds(calendar, m_utc)) * 1'000'000'000;
+            std::copy(minute.begin(), minute.end(), m_minute.begin());
+        }
+
+        ns = m_minuteNs + static_cast<int64_t>(number(line.substr(18, 2))) * 1'000'000'000;
+
+        std::size_t position = SHAPE.size();
+        if (position < line.size() and line[position] == '.')
+        {
+            int64_t fraction = 0;
+            int64_t scale = 1'000'000'000;
+            for (position++; position < line.size() and line[position] >= '0' and line[position] <= '9'; position++)
+            {
+                fraction = fraction * 10 + (line[position] - '0');
+                scale /= 10;
+            }
+            ns += fraction * scale;
+        }
+
+        while (position < line.size() and line[position] == ' ')
+            position++;
+
+        const auto end = line.find(']', position);
+        return end != std::string_view::npos and parseLevel(line.substr(position, end - position), level);
+    }
+
+private:
+    bool m_utc;
+    std::array<char, 16> m_minute{};
+    int64_t m_minuteNs = 0;
+
+    static int number(const std::string_view digits)
+    {
+        int value = 0;
+        for (const char digit: digits)
+            value = value * 10 + (digit - '0');
+        return value;
+    }
+};
+
+/* Prints the matching lines of one range, which starts at a record */
+void queryRange(std::ifstream &file, const slog::LogIndexRange &range, const Query &query, LineParser &parser)
+{
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(range.offset));
+
+    std::string chunk;
+    std::string line;
+    bool matching = true;
+    uint64_t remaining = range.length;
+
+    while (remaining != 0 and file)
+    {
+        chunk.resize(std::min<uint64_t>(remaining, READ_CHUNK_SIZE));
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        chunk.resize(static_cast<std::size_t>(file.gcount()));
+        remaining -= chunk.size();
+
+        std::string_view data = chunk;
+        while (!data.empty())
+        {
+            const auto newline = data.find('\n');
+            if (newline == std::string_view::npos and remaining != 0)
+            {
+                // Continues in the next chunk
+                line.append(data);
+                break;
+            }
+
+            const std::size_t length = newline == std::string_view::npos ? data.size() : newline + 1;
+            line.append(data.substr(0, length));
+            data.remove_prefix(length);
+
+            int64_t ns = 0;
+            slog::LogLevel level{};
+            if (parser.parse(line, ns, level))
+                matching = ns >= query.fromNs and ns < query.toNs and (slog::levelBit(level) & query.levels) != 0;
+
+            if (matching)
+                std::fwrite(line.data(), 1, line.size(), stdout);
+            line.clear();
+        }
+    }
+}
+
+} // namespace
+
+int main(const int argc, char **argv)
+{
+    Query query;
+    bool stats = false;
+    std::string from;
+    std::string to;
+    std::string filename;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+
+        if (argument == "--utc")
+        {
+            query.utc = true;
+        }
+        else if (argument == "--stats")
+        {
+            stats = true;
+        }
+        else if (argument == "--from" and i + 1 < argc)
+        {
+            from = argv[++i];
+        }
+        else if (argument == "--to" and i + 1 < argc)
+        {
+            to = argv[++i];
+        }
+        else if (argument == "--level" and i + 1 < argc)
+        {
+            if (!parseLevels(argv[++i], query.levels))
+                return usage();
+        }
+        else if (argument == "--min-level" and i + 1 < argc)
+        {
+            slog::LogLevel level{};
+            if (!parseLevel(argv[++i], level))
+                return usage();
+
+            query.levels = slog::levelRangeMask(level, slog::LogLevel::FATAL);
+        }
+        else if (argument.starts_with("-") or !filename.empty())
+        {
+            return usage();
+        }
+        else
+        {
+            filename = argument;
+        }
+    }
+
+    if (filename.empty() or (!from.empty() and !parseQueryTime(from, query.utc, query.fromNs)) or
+        (!to.empty() and !parseQueryTime(to, query.utc, query.toNs)))
+    {
+        return usage();
+    }
+
+    std::ifstream file(filename, std::ios::binary);
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(filename, error);
+    if (!file.is_open() or error)
+    {
+        std::cerr << "slog-query: " << filename << ": could not open the file" << std::endl;
+        return 1;
+    }
+
+    std::vector<slog::LogIndexRange> ranges{{0, size}};
+    std::size_t entries = 0;
+    try
+    {
+        const slog::LogIndexReader index(slog::logIndexPath(filename));
+        ranges = index.find(query.fromNs, query.toNs, query.levels, size);
+        entries = index.entries().size();
+    }
+    catch (const slog::LogException &exception)
+    {
+        std::cerr << "slog-query: " << exception.what() << ", reading the whole file" << std::endl;
+    }
+
+    LineParser parser(query.utc);
+    uint64_t read = 0;
+    for (const auto &range: ranges)
+    {
+        queryRange(file, range, query, parser);
+        read += range.length;
+    }
+
+    std::fflush(stdout);
+    if (stats)
+    {
+        std::cerr << "slog-query: read " << read << " of " << size << " bytes in " << ranges.size() << " ranges ("
+                  << entries << " index entries)" << std::endl;
+    }
+
+    return 0;
+}
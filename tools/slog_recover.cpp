@@ -0,0 +1,87 @@
+/*
+ * @brief Prints the records left in a FlightRecorder file (or a core dump containing one)
+ *
+ * Usage: slog-recover [--utc] [--precision ms|us|ns] <file|core>...
+ *
+ * @author Matthew Brown
+ * @date 6/15/2024
+ */
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flightrecorder.hpp"
+
+namespace
+{
+
+int usage()
+{
+    std::cerr << "Usage: slog-recover [--utc] [--precision ms|us|ns] <file|core>..." << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(const int argc, char **argv)
+{
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+
+        if (argument == "--utc")
+        {
+            slog::setTimeZone(slog::TimeZone::UTC);
+        }
+        else if (argument == "--precision" and i + 1 < argc)
+        {
+            const std::string_view precision = argv[++i];
+            if (precision == "ms")
+                slog::setTimePrecision(slog::TimePrecision::MILLISECONDS);
+            else if (precision == "us")
+                slog::setTimePrecision(slog::TimePrecision::MICROSECONDS);
+            else if (precision == "ns")
+                slog::setTimePrecision(slog::TimePrecision::NANOSECONDS);
+            else
+                return usage();
+        }
+        else if (argument.starts_with("-"))
+        {
+            return usage();
+        }
+        else
+        {
+            files.emplace_back(argument);
+        }
+    }
+
+    if (files.empty())
+        return usage();
+
+    std::string line;
+
+    for (const auto &file: files)
+    {
+        try
+        {
+            for (const auto &record: slog::FlightRecorder::recover(file))
+            {
+                line.clear();
+                slog::formatLogLine(line, record);
+                std::fwrite(line.data(), 1, line.size(), stdout);
+            }
+        }
+        catch (const slog::LogException &exception)
+        {
+            std::fflush(stdout);
+            std::cerr << "slog-recover: " << file << ": " << exception.what() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}